@@ -10,12 +10,16 @@ Fixes:
 """
 
 import argparse
+import mmap
 import os
+import re
 import struct
 import sys
 import threading
 import traceback
+import heapq
 import time
+from collections import deque
 from pathlib import Path
 
 # Add parent directory for imports
@@ -25,6 +29,7 @@ sys.path.insert(0, str(Path(__file__).parent.parent))
 if sys.platform == "win32":
     import win32pipe
     import win32file
+    import win32event
     import win32security
     import pywintypes
 else:
@@ -46,6 +51,135 @@ ERR_UNKNOWN = 99
 # Request flags (for future extensibility)
 FLAG_NONE = 0x00000000
 FLAG_NO_SILENCE_PAD = 0x00000001  # Skip silence padding if client handles it
+FLAG_SHM_AUDIO = 0x00000002       # Audio payload rides the shared-memory ring
+FLAG_PRIORITY_HIGH = 0x00000004   # Alerts/interactive prompts
+FLAG_PRIORITY_LOW = 0x00000008    # Background narration, lookahead
+FLAG_FLOW_CONTROL = 0x00000010    # Client replenishes chunk credits as it plays
+FLAG_WORD_EVENTS = 0x00000020     # Interleave word-boundary metadata frames
+FLAG_ADPCM_AUDIO = 0x00000040     # IMA-ADPCM compress chunks (remote clients)
+FLAG_BULK = 0x00000080            # Offline speak-to-file: batch for throughput
+
+# Bulk requests coalesce model output into ~2s frames before writing, so an
+# overnight render spends its pipe writes, credit cycles and client wakeups
+# on seconds of audio at a time instead of one model hop
+BULK_FRAME_BYTES = SAMPLE_RATE * 2 * 2
+
+# Per-stream bound on audio chunks buffered between the generation thread and
+# the consumer loop in _synthesize. When the loop stops pulling (flow-control
+# park, priority yield, slow pipe) the generation thread blocks in the
+# streamer after this much lookahead, so the GPU genuinely goes idle instead
+# of rendering ahead into an unbounded queue.
+MAX_BUFFERED_CHUNKS = 4
+
+# Scheduling priorities derived from the request flags
+PRIORITY_LOW = 0
+PRIORITY_NORMAL = 1
+PRIORITY_HIGH = 2
+
+
+def request_priority(flags: int) -> int:
+    if flags & FLAG_PRIORITY_HIGH:
+        return PRIORITY_HIGH
+    if flags & FLAG_PRIORITY_LOW:
+        return PRIORITY_LOW
+    return PRIORITY_NORMAL
+
+# Protocol opcodes (client -> server, sent in place of the text length field).
+# Kept at the top of the DWORD range so they can never collide with a real
+# text length - or, on the return path, with a request ID.
+OP_PING = 0xFFFFFFF0
+OP_CANCEL = 0xFFFFFFF1  # Followed by the 4-byte request ID to cancel
+OP_PRELOAD_VOICE = 0xFFFFFFF2
+OP_REQUEST_V2 = 0xFFFFFFF3
+OP_SETUP_SHM = 0xFFFFFFF4
+OP_CREDIT = 0xFFFFFFF5  # Followed by [requestId:4][count:4] - grant chunks
+
+# Length-field sentinel on the response path: the frame is timing metadata
+# ([type:4][textOffset:4][textLen:4]) rather than an audio chunk
+META_FRAME = 0xFFFFFFFE
+EVT_WORD_BOUNDARY = 1
+
+# Pacing model for word-boundary metadata: ~14 characters of text per second
+# of speech at this model's default speaking rate
+BYTES_PER_CHAR = int(SAMPLE_RATE * 2 / 14)
+
+# Shared-memory ring layout: [writePos:8][readPos:8][data]
+SHM_HEADER_SIZE = 16
+
+
+class AdpcmEncoder:
+    """
+    IMA/DVI ADPCM encoder: 16-bit PCM in, 4 bits per sample out (high nibble
+    first). Remote clients request this via FLAG_ADPCM_AUDIO to cut wire
+    bytes ~4x; the SAPI DLL decodes with the matching tables. State runs
+    across chunks, so one encoder serves one request for its whole stream.
+    Self-contained because the stdlib audioop module is gone in Python 3.13.
+    """
+
+    _INDEX_TABLE = [-1, -1, -1, -1, 2, 4, 6, 8,
+                    -1, -1, -1, -1, 2, 4, 6, 8]
+    _STEP_TABLE = [
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+        19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+        130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+        337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+        876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+        2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+        5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767]
+
+    def __init__(self):
+        self._predictor = 0
+        self._index = 0
+
+    def encode(self, pcm_bytes: bytes) -> bytes:
+        samples = memoryview(pcm_bytes).cast('h')
+        n = len(samples)
+        if n % 2:
+            # Nibble-pair the tail by repeating the last sample; the model's
+            # chunks are even-length so this is a corner case, and the extra
+            # decoded sample is one 42us repeat
+            samples = list(samples) + [samples[-1]]
+            n += 1
+        out = bytearray(n // 2)
+        predictor = self._predictor
+        index = self._index
+        step_table = self._STEP_TABLE
+        index_table = self._INDEX_TABLE
+        for i in range(n):
+            sample = samples[i]
+            step = step_table[index]
+            diff = sample - predictor
+            sign = 8 if diff < 0 else 0
+            if sign:
+                diff = -diff
+            delta = 0
+            vpdiff = step >> 3
+            if diff >= step:
+                delta = 4
+                diff -= step
+                vpdiff += step
+            step >>= 1
+            if diff >= step:
+                delta |= 2
+                diff -= step
+                vpdiff += step
+            step >>= 1
+            if diff >= step:
+                delta |= 1
+                vpdiff += step
+            predictor += -vpdiff if sign else vpdiff
+            predictor = max(-32768, min(32767, predictor))
+            delta |= sign
+            index = max(0, min(88, index + index_table[delta]))
+            if i & 1:
+                out[i >> 1] |= delta
+            else:
+                out[i >> 1] = delta << 4
+        self._predictor = predictor
+        self._index = index
+        return bytes(out)
 
 
 # --- FIX FOR CRASH: SafeEvent ---
@@ -65,14 +199,105 @@ class SafeEvent(threading.Event):
         return (SafeEvent, ())
 
 
+class PriorityLock:
+    """
+    A lock whose waiters are served highest-priority first (FIFO within a
+    priority). An urgent interactive prompt queued behind minutes of
+    narration acquires the model as soon as the current chunk finishes,
+    instead of waiting out the whole backlog.
+    """
+
+    def __init__(self):
+        self._cv = threading.Condition()
+        self._held = False
+        self._waiters = []  # Heap of (-priority, seq) tickets
+        self._seq = 0
+
+    def acquire(self, priority: int = PRIORITY_NORMAL):
+        with self._cv:
+            self._seq += 1
+            ticket = (-priority, self._seq)
+            heapq.heappush(self._waiters, ticket)
+            while self._held or self._waiters[0] != ticket:
+                self._cv.wait()
+            heapq.heappop(self._waiters)
+            self._held = True
+
+    def release(self):
+        with self._cv:
+            self._held = False
+            self._cv.notify_all()
+
+    def waiting_priority(self):
+        """Highest priority currently queued, or None if nobody waits."""
+        with self._cv:
+            return -self._waiters[0][0] if self._waiters else None
+
+
+class ShmAudioRing:
+    """
+    Server side of the negotiated shared-memory audio path.
+
+    The client creates a named file mapping plus a '<name>_space' event and
+    announces them via OP_SETUP_SHM. PCM chunks are written into the ring and
+    only the 4-byte length frame travels over the pipe. Chunks never wrap:
+    when a chunk doesn't fit in the tail of the ring, the writer skips to the
+    ring start and the client mirrors the same rule, so every chunk is a
+    contiguous region the client can pass to SAPI without copying.
+    """
+
+    def __init__(self, name: str, size: int):
+        self.size = size
+        self.mm = mmap.mmap(-1, SHM_HEADER_SIZE + size, tagname=name)
+        self.space_event = win32event.OpenEvent(
+            win32event.SYNCHRONIZE | win32event.EVENT_MODIFY_STATE,
+            False, name + "_space")
+        self.write_pos = struct.unpack_from('<Q', self.mm, 0)[0]
+
+    def _read_pos(self) -> int:
+        return struct.unpack_from('<Q', self.mm, 8)[0]
+
+    def write_chunk(self, data: bytes, timeout_s: float = 30.0) -> bool:
+        length = len(data)
+        if length > self.size:
+            return False
+
+        offset = self.write_pos % self.size
+        skip = 0
+        if self.size - offset < length:
+            skip = self.size - offset  # Keep the chunk contiguous
+            offset = 0
+
+        # Wait for the client to free enough ring space
+        deadline = time.monotonic() + timeout_s
+        while self.size - (self.write_pos + skip + length - self._read_pos()) < 0:
+            if time.monotonic() > deadline:
+                return False
+            win32event.WaitForSingleObject(self.space_event, 100)
+
+        self.mm[SHM_HEADER_SIZE + offset:SHM_HEADER_SIZE + offset + length] = data
+        self.write_pos += skip + length
+        struct.pack_into('<Q', self.mm, 0, self.write_pos)
+        return True
+
+    def close(self):
+        try:
+            self.mm.close()
+        except Exception:
+            pass
+
+
 class SAPIPipeServer:
-    def __init__(self, model_path: str, device: str = "cuda", inference_steps: int = 5):
+    def __init__(self, model_path: str, device: str = "cuda", inference_steps: int = 5,
+                 credit_window: int = 16):
         self.model_path = model_path
         self.device = device
         self.inference_steps = inference_steps
+        self.credit_window = credit_window
         self.tts_service = None
         self.running = False
-        self._lock = threading.Lock()
+        self._lock = threading.Lock()          # Short reads of shared dicts
+        self._model_lock = PriorityLock()      # Serializes model access
         
         # Security Attributes for OneCore/Settings App visibility
         self._security_attributes = self._create_low_integrity_security_attributes()
@@ -132,18 +357,35 @@ class SAPIPipeServer:
             self._security_attributes
         )
 
-    def write_audio_chunk(self, pipe, chunk: bytes):
-        length_data = struct.pack('<I', len(chunk))
-        win32file.WriteFile(pipe, length_data)
+    def write_audio_chunk(self, pipe, chunk: bytes, shm=None, request_id=None):
+        # Multiplexed (v2-with-ID) streams prefix every frame with the
+        # request ID so the client's demux reader can route it
+        prefix = struct.pack('<I', request_id) if request_id is not None else b''
+        if shm is not None and len(chunk) > 0:
+            # Payload goes through the shared-memory ring; the pipe carries
+            # only the length frame as the signal. Mixing transports within
+            # a stream would desync the client, so a ring stall is fatal.
+            if not shm.write_chunk(chunk):
+                raise RuntimeError("SHM audio ring stalled")
+            win32file.WriteFile(pipe, prefix + struct.pack('<I', len(chunk)))
+            return
+        win32file.WriteFile(pipe, prefix + struct.pack('<I', len(chunk)))
         if len(chunk) > 0:
             win32file.WriteFile(pipe, chunk)
 
-    def write_end_of_stream(self, pipe):
-        win32file.WriteFile(pipe, struct.pack('<I', 0))
+    def write_word_event(self, pipe, request_id, offset, length):
+        """Interleave a word-boundary metadata frame into a tagged stream."""
+        win32file.WriteFile(pipe, struct.pack(
+            '<IIIII', request_id, META_FRAME, EVT_WORD_BOUNDARY, offset, length))
+
+    def write_end_of_stream(self, pipe, request_id=None):
+        prefix = struct.pack('<I', request_id) if request_id is not None else b''
+        win32file.WriteFile(pipe, prefix + struct.pack('<I', 0))
 
-    def write_error(self, pipe, error_code: int, message: str):
+    def write_error(self, pipe, error_code: int, message: str, request_id=None):
         try:
-            win32file.WriteFile(pipe, struct.pack('<I', 0xFFFFFFFF))
+            prefix = struct.pack('<I', request_id) if request_id is not None else b''
+            win32file.WriteFile(pipe, prefix + struct.pack('<I', 0xFFFFFFFF))
             win32file.WriteFile(pipe, struct.pack('<I', error_code))
             msg_bytes = message.encode('utf-8')[:255]
             msg_padded = msg_bytes + b'\x00' * (256 - len(msg_bytes))
@@ -151,6 +393,61 @@ class SAPIPipeServer:
         except:
             pass
 
+    def _poll_client(self, pipe, state, current_id) -> bool:
+        """
+        Poll for client messages arriving mid-stream. An OP_CANCEL for the
+        current request returns True so diffusion stops burning GPU time
+        immediately; cancels for other requests are remembered, and new
+        requests are queued so concurrent Speak calls can pipeline over one
+        connection instead of waiting for a connect.
+        """
+        cancelled = False
+        try:
+            while True:
+                data, _, _ = win32pipe.PeekNamedPipe(pipe, 4)
+                if len(data) < 4:
+                    break
+                hr, raw = win32file.ReadFile(pipe, 4)
+                opcode = struct.unpack('<I', raw)[0]
+                if opcode == OP_CANCEL:
+                    hr, raw = win32file.ReadFile(pipe, 4)
+                    cancel_id = struct.unpack('<I', raw)[0]
+                    if current_id is not None and cancel_id == current_id:
+                        cancelled = True
+                    else:
+                        state['cancelled_ids'].add(cancel_id)
+                elif opcode == OP_PING:
+                    win32file.WriteFile(pipe, struct.pack('<II', OP_PING, 0))
+                elif opcode == OP_REQUEST_V2:
+                    state['pending'].append(self._read_request_v2(pipe))
+                elif opcode == OP_CREDIT:
+                    hr, raw = win32file.ReadFile(pipe, 8)
+                    cid, count = struct.unpack('<II', raw)
+                    state['credits'][cid] = state['credits'].get(cid, 0) + count
+                else:
+                    print(f"[Warning] Unexpected data mid-stream: 0x{opcode:08X}")
+                    break
+        except pywintypes.error:
+            return True  # Client is gone - treat as cancelled
+        return cancelled
+
+    def _read_request_v2(self, pipe) -> dict:
+        """Read the remainder of a v2 request after its opcode."""
+        hr, data = win32file.ReadFile(pipe, 4)
+        version, header_bytes = struct.unpack('<HH', data)
+        # Fixed fields after opcode/version/headerBytes: textBytes, flags,
+        # voiceId[32], requestId. Extra bytes from newer clients are read
+        # and ignored; older clients simply omit the request ID.
+        hr, data = win32file.ReadFile(pipe, header_bytes - 8)
+        text_bytes, flags = struct.unpack_from('<II', data, 0)
+        voice_id = data[8:40].rstrip(b'\x00').decode('ascii', errors='ignore')
+        request_id = struct.unpack_from('<I', data, 40)[0] if len(data) >= 44 else None
+        text = ''
+        if text_bytes:
+            hr, data = win32file.ReadFile(pipe, text_bytes)
+            text = data.decode('utf-16-le')
+        return {'text': text, 'voice_id': voice_id, 'flags': flags, 'id': request_id}
+
     def _resolve_voice(self, voice_id: str) -> tuple[str | None, bool]:
         """
         Resolve voice ID to a valid voice key.
@@ -173,15 +470,132 @@ class SAPIPipeServer:
         return None, False
 
     def handle_client(self, pipe):
+        """
+        Serve requests on one connection until the client disconnects.
+        Connections are persistent and multiplexed: clients keep the pipe
+        open across utterances, tag requests with IDs, and may send the next
+        request while a stream is still playing - it lands in the pending
+        queue and is served as soon as the model frees up.
+        """
+        # Per-connection state: the negotiated SHM ring, requests queued
+        # behind the current stream, and cancels for not-yet-served requests
+        state = {'shm': None, 'pending': deque(), 'cancelled_ids': set(),
+                 'credits': {}}
+        try:
+            while self.running:
+                if state['pending']:
+                    # Serve the most urgent queued request first (FIFO
+                    # within a priority level)
+                    pending = state['pending']
+                    best = max(range(len(pending)),
+                               key=lambda i: (request_priority(pending[i]['flags']), -i))
+                    req = pending[best]
+                    del pending[best]
+                    if req['id'] in state['cancelled_ids']:
+                        # Cancelled before it reached the model; the stream
+                        # still owes the client its end-of-stream frame
+                        state['cancelled_ids'].discard(req['id'])
+                        self.write_end_of_stream(pipe, req['id'])
+                        continue
+                    shm = state['shm'] if (req['flags'] & FLAG_SHM_AUDIO) else None
+                    if not self._synthesize(pipe, req['text'], req['voice_id'],
+                                            req['flags'], shm, req['id'], state):
+                        break
+                    continue
+                state['cancelled_ids'].clear()  # Only meaningful while queued
+                if not self._serve_one(pipe, state):
+                    break
+        finally:
+            if state.get('shm') is not None:
+                state['shm'].close()
+
+    def _serve_one(self, pipe, state) -> bool:
+        """Handle a single request. Returns False when the client is gone."""
         try:
             # --- READ REQUEST ---
-            hr, data = win32file.ReadFile(pipe, 4)
+            try:
+                hr, data = win32file.ReadFile(pipe, 4)
+            except pywintypes.error:
+                return False  # Client closed the connection
             if len(data) < 4:
-                return
+                return False
             text_len = struct.unpack('<I', data)[0]
+
+            # Keep-alive ping: echo the opcode (tagged-frame shaped, so the
+            # client's demux reader parses it) and wait for the next request
+            if text_len == OP_PING:
+                win32file.WriteFile(pipe, struct.pack('<II', OP_PING, 0))
+                return True
+
+            # A cancel that raced the end of its stream; nothing to stop
+            if text_len == OP_CANCEL:
+                hr, data = win32file.ReadFile(pipe, 4)
+                if len(data) >= 4:
+                    state['cancelled_ids'].add(struct.unpack('<I', data)[0])
+                return True
+
+            # A credit grant that arrived between requests - usually the
+            # tail-end batch for a stream that already finished
+            if text_len == OP_CREDIT:
+                hr, data = win32file.ReadFile(pipe, 8)
+                if len(data) >= 8:
+                    cid, count = struct.unpack('<II', data)
+                    state['credits'][cid] = state['credits'].get(cid, 0) + count
+                return True
+
+            # Voice warm-up: load the voice preset now so the first Speak
+            # finds it cached. Fire-and-forget - no reply is sent.
+            if text_len == OP_PRELOAD_VOICE:
+                hr, data = win32file.ReadFile(pipe, 32)
+                voice_id = data.rstrip(b'\x00').decode('ascii', errors='ignore')
+                with self._lock:
+                    voice_key, voice_found = self._resolve_voice(voice_id)
+                if voice_found and voice_key:
+                    # Warm-up is opportunistic - never make a real request wait
+                    self._model_lock.acquire(PRIORITY_LOW)
+                    try:
+                        self.tts_service._ensure_voice_cached(voice_key)
+                        print(f"[Preload] Voice '{voice_key}' warmed.")
+                    except Exception as e:
+                        print(f"[Preload] Failed for '{voice_id}': {e}")
+                    finally:
+                        self._model_lock.release()
+                else:
+                    print(f"[Preload] Unknown voice '{voice_id}' - ignored.")
+                return True
+
+            # Shared-memory transport negotiation: the client created the
+            # mapping and space event; we open them and acknowledge
+            if text_len == OP_SETUP_SHM:
+                hr, data = win32file.ReadFile(pipe, 4 + 64)
+                ring_bytes = struct.unpack_from('<I', data, 0)[0]
+                name = data[4:68].rstrip(b'\x00').decode('ascii', errors='ignore')
+                status = 0
+                try:
+                    state['shm'] = ShmAudioRing(name, ring_bytes)
+                    print(f"[SHM] Audio ring attached: {name} ({ring_bytes} bytes)")
+                except Exception as e:
+                    print(f"[SHM] Setup failed for '{name}': {e}")
+                    state['shm'] = None
+                    status = 1
+                win32file.WriteFile(pipe, struct.pack('<II', OP_SETUP_SHM, status))
+                return True
+
+            # Protocol v2: one contiguous [header][text] buffer. The header
+            # carries its own size so future versions can append fields.
+            if text_len == OP_REQUEST_V2:
+                req = self._read_request_v2(pipe)
+                if not req['text']:
+                    self.write_error(pipe, ERR_EMPTY_TEXT, "Empty text length", req['id'])
+                    return True
+                shm = state.get('shm') if (req['flags'] & FLAG_SHM_AUDIO) else None
+                return self._synthesize(pipe, req['text'], req['voice_id'],
+                                        req['flags'], shm, req['id'], state)
+
+            # Protocol v1 (legacy one-shot clients): sequential fields
             if text_len == 0:
                 self.write_error(pipe, ERR_EMPTY_TEXT, "Empty text length")
-                return
+                return True
 
             hr, data = win32file.ReadFile(pipe, text_len)
             text = data.decode('utf-16-le')
@@ -193,15 +607,56 @@ class SAPIPipeServer:
             hr, data = win32file.ReadFile(pipe, 4)
             flags = struct.unpack('<I', data)[0] if len(data) >= 4 else FLAG_NONE
 
+            return self._synthesize(pipe, text, voice_id, flags, state=state)
+
+        except pywintypes.error as e:
+            # Pipe errors (client disconnected, etc.) - log but don't write error
+            print(f"[Pipe Error] {e}")
+            return False
+        except Exception as e:
+            # A failure this early means we don't know which request the
+            # bytes belonged to; an untagged error frame would desync the
+            # client's demux reader, so drop the connection instead
+            print(f"[Error] {e}")
+            traceback.print_exc()
+            return False
+
+    def _synthesize(self, pipe, text: str, voice_id: str, flags: int, shm=None,
+                    request_id=None, state=None) -> bool:
+        """Validate, synthesize and stream one utterance back to the client."""
+        if state is None:
+            state = {'pending': deque(), 'cancelled_ids': set(), 'credits': {}}
+        try:
             print(f"[Request] {text[:40]}{'...' if len(text) > 40 else ''} (voice={voice_id}, flags=0x{flags:08X})")
 
+            # Word boundaries are reported against the text exactly as the
+            # client sent it - normalization below may shift characters
+            words = []
+            if request_id is not None and (flags & FLAG_WORD_EVENTS):
+                words = [(m.start(), m.end() - m.start())
+                         for m in re.finditer(r'\S+', text)]
+            word_i = 0
+            emitted_bytes = 0
+
+            # Remote clients trade a cheap decode for ~4x fewer wire bytes.
+            # Mutually exclusive with the SHM ring (local-only) by design.
+            encoder = None
+            if request_id is not None and (flags & FLAG_ADPCM_AUDIO) and shm is None:
+                encoder = AdpcmEncoder()
+
+            # Speak-to-file render jobs: the generation windows are model
+            # constants, so batching happens at the framing layer instead -
+            # output coalesces into BULK_FRAME_BYTES frames before writing
+            bulk = request_id is not None and bool(flags & FLAG_BULK)
+            bulk_buf = bytearray()
+
             # --- VALIDATE AND PREPARE ---
             text = self._normalize_text(text)
 
             # Check for empty text after normalization
             if not text:
-                self.write_error(pipe, ERR_EMPTY_TEXT, "Text is empty after normalization")
-                return
+                self.write_error(pipe, ERR_EMPTY_TEXT, "Text is empty after normalization", request_id)
+                return True
 
             # Resolve Voice ID (thread-safe read)
             with self._lock:
@@ -209,34 +664,138 @@ class SAPIPipeServer:
 
             if not voice_found:
                 available = ", ".join(self.tts_service.voice_presets.keys())
-                self.write_error(pipe, ERR_INVALID_VOICE, f"Voice '{voice_id}' not found. Available: {available}")
-                return
+                self.write_error(pipe, ERR_INVALID_VOICE, f"Voice '{voice_id}' not found. Available: {available}", request_id)
+                return True
 
             # USE SAFE EVENT (Fixes the crash)
             stop_event = SafeEvent()
 
-            # --- STREAM (thread-safe) ---
+            # --- STREAM (thread-safe, priority-scheduled) ---
             chunk_count = 0
-            with self._lock:
+            cancelled = False
+            priority = request_priority(flags)
+
+            # Flow control: each chunk sent spends a credit; the client
+            # replenishes them as SAPI actually consumes audio. When the
+            # window is exhausted this loop parks with the model lock
+            # released - and because the streamer queue is bounded, the
+            # generation thread blocks shortly after we stop pulling, so the
+            # GPU serves other voices instead of building minutes of
+            # lookahead nobody has heard yet.
+            flow_control = request_id is not None and (flags & FLAG_FLOW_CONTROL)
+            credits = self.credit_window
+
+            self._model_lock.acquire(priority)
+            try:
                 for audio_chunk in self.tts_service.stream(
                     text=text,
                     voice_key=voice_key,
-                    stop_event=stop_event
+                    stop_event=stop_event,
+                    max_buffered_chunks=MAX_BUFFERED_CHUNKS
                 ):
+                    # Client-initiated cancel stops diffusion right away;
+                    # queued requests and foreign cancels are absorbed too
+                    if self._poll_client(pipe, state, request_id):
+                        cancelled = True
+                        stop_event.set()
+                        break
                     pcm_bytes = self.tts_service.chunk_to_pcm16(audio_chunk)
-                    self.write_audio_chunk(pipe, pcm_bytes)
-                    chunk_count += 1
+
+                    if bulk:
+                        # Accumulate until a full bulk frame is ready; the
+                        # priority yield below still runs every model hop
+                        bulk_buf += pcm_bytes
+                        if len(bulk_buf) < BULK_FRAME_BYTES:
+                            pcm_bytes = b''
+                        else:
+                            pcm_bytes = bytes(bulk_buf)
+                            del bulk_buf[:]
+
+                    if pcm_bytes:
+                        # Announce the words this chunk is estimated to
+                        # cover before the audio itself, so the client fires
+                        # each boundary event no later than the matching
+                        # samples. The pacing model is approximate; words
+                        # still unannounced at end of stream flush below.
+                        while (word_i < len(words) and
+                               words[word_i][0] <= emitted_bytes / BYTES_PER_CHAR):
+                            self.write_word_event(pipe, request_id, *words[word_i])
+                            word_i += 1
+
+                        # Pacing and credits stay in decoded terms; only the
+                        # wire representation changes
+                        wire_bytes = encoder.encode(pcm_bytes) if encoder else pcm_bytes
+                        self.write_audio_chunk(pipe, wire_bytes, shm, request_id)
+                        emitted_bytes += len(pcm_bytes)
+                        chunk_count += 1
+
+                    if flow_control and pcm_bytes:
+                        credits += state['credits'].pop(request_id, 0)
+                        credits -= 1
+                        if credits <= 0:
+                            # Out of credits - park until the client catches
+                            # up, without holding the model hostage
+                            self._model_lock.release()
+                            deadline = time.monotonic() + 30.0
+                            try:
+                                while credits <= 0:
+                                    if self._poll_client(pipe, state, request_id):
+                                        cancelled = True
+                                        stop_event.set()
+                                        break
+                                    credits += state['credits'].pop(request_id, 0)
+                                    if credits > 0:
+                                        break
+                                    if time.monotonic() > deadline:
+                                        raise RuntimeError(
+                                            "Flow-control credits stalled")
+                                    time.sleep(0.02)
+                            finally:
+                                self._model_lock.acquire(priority)
+                            if cancelled:
+                                break
+
+                    # Interleave: yield the model between chunks when a more
+                    # urgent request is waiting. Safe because each generate()
+                    # call runs on a private diffusion scheduler and deep-
+                    # copied KV caches - overlap can't corrupt either stream,
+                    # so pausing here only delays this utterance and the
+                    # alert reaches first-audio immediately.
+                    waiting = self._model_lock.waiting_priority()
+                    if waiting is not None and waiting > priority:
+                        self._model_lock.release()
+                        self._model_lock.acquire(priority)
+            finally:
+                self._model_lock.release()
+                state['credits'].pop(request_id, None)
+
+            # Flush the partially filled last bulk frame
+            if not cancelled and bulk_buf:
+                tail = bytes(bulk_buf)
+                if encoder:
+                    tail = encoder.encode(tail)
+                self.write_audio_chunk(pipe, tail, shm, request_id)
+                emitted_bytes += len(bulk_buf)
+                chunk_count += 1
 
             # --- FIX FOR CUTOFFS: PAD SILENCE ---
             # SAPI sometimes drops the last buffer. We push 300ms of silence to flush it.
             # Can be disabled via FLAG_NO_SILENCE_PAD if client handles buffering.
-            if not (flags & FLAG_NO_SILENCE_PAD):
+            if not cancelled and not (flags & FLAG_NO_SILENCE_PAD):
                 silence_samples = int(SAMPLE_RATE * 0.3)
                 silence_bytes = b'\x00' * (silence_samples * 2)
-                self.write_audio_chunk(pipe, silence_bytes)
+                if encoder:
+                    silence_bytes = encoder.encode(silence_bytes)
+                self.write_audio_chunk(pipe, silence_bytes, shm, request_id)
+
+            # Flush word boundaries the pacing model hadn't reached yet
+            if not cancelled:
+                while word_i < len(words):
+                    self.write_word_event(pipe, request_id, *words[word_i])
+                    word_i += 1
 
             # End Stream
-            self.write_end_of_stream(pipe)
+            self.write_end_of_stream(pipe, request_id)
 
             # Force flush to ensure SAPI gets the data before we close
             try:
@@ -244,18 +803,24 @@ class SAPIPipeServer:
             except pywintypes.error:
                 pass
 
-            print(f"[Done] Sent {chunk_count} chunks.")
+            if cancelled:
+                print(f"[Cancelled] Stopped after {chunk_count} chunks.")
+            else:
+                print(f"[Done] Sent {chunk_count} chunks.")
+            return True
 
         except pywintypes.error as e:
             # Pipe errors (client disconnected, etc.) - log but don't write error
             print(f"[Pipe Error] {e}")
+            return False
         except Exception as e:
             print(f"[Error] {e}")
             traceback.print_exc()
             try:
-                self.write_error(pipe, ERR_MODEL_ERROR, str(e)[:200])
+                self.write_error(pipe, ERR_MODEL_ERROR, str(e)[:200], request_id)
+                return True
             except:
-                pass
+                return False
 
     def run(self):
         self.running = True
@@ -302,6 +867,9 @@ def main():
                         help="Device to run on (cuda, cpu, mps)")
     parser.add_argument("--inference_steps", type=int, default=5,
                         help="Number of diffusion inference steps (default: 5)")
+    parser.add_argument("--credit_window", type=int, default=16,
+                        help="Max unacknowledged audio chunks per flow-controlled "
+                             "stream (default: 16)")
     args = parser.parse_args()
 
     # Change to directory of script
@@ -310,7 +878,8 @@ def main():
     server = SAPIPipeServer(
         model_path=args.model_path,
         device=args.device,
-        inference_steps=args.inference_steps
+        inference_steps=args.inference_steps,
+        credit_window=args.credit_window
     )
     try:
         server.load_model()
@@ -244,6 +244,7 @@ class StreamingTTSService:
         voice_key: Optional[str] = None,
         log_callback: Optional[Callable[[str, Dict[str, Any]], None]] = None,
         stop_event: Optional[threading.Event] = None,
+        max_buffered_chunks: Optional[int] = None,
     ) -> Iterator[np.ndarray]:
         if not text.strip():
             return
@@ -270,7 +271,13 @@ class StreamingTTSService:
         self.inference_steps = steps_to_use
 
         inputs = self._prepare_inputs(text, prefilled_outputs)
-        audio_streamer = AudioStreamer(batch_size=1, stop_signal=None, timeout=None)
+        # A bound makes the generation thread block in the streamer once the
+        # consumer falls behind, so callers that pause consumption (e.g. the
+        # SAPI server's flow control) genuinely pause the GPU too
+        audio_streamer = AudioStreamer(
+            batch_size=1, stop_signal=None, timeout=None,
+            maxsize=max_buffered_chunks or 0,
+        )
         errors: list = []
         stop_signal = stop_event or threading.Event()
 
@@ -0,0 +1,236 @@
+// AudioCache.cpp
+// Client-side audio cache keyed by (text, voice) with memory-mapped storage
+
+#include "AudioCache.h"
+#include "PerfCounters.h"
+
+namespace {
+
+// Mapping and mutex names are machine-local so every SAPI host process on
+// the box shares one cache
+constexpr wchar_t CACHE_MUTEX_NAME[] = L"Local\\VibeVoiceAudioCacheLock";
+constexpr wchar_t CACHE_MAPPING_NAME[] = L"Local\\VibeVoiceAudioCache";
+constexpr wchar_t CACHE_FILE_NAME[] = L"audio_cache.bin";
+
+// FNV-1a, 64-bit
+ULONGLONG HashBytes(ULONGLONG hash, const void* data, size_t size)
+{
+    const BYTE* bytes = static_cast<const BYTE*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+}  // namespace
+
+//=============================================================================
+// AudioCache Implementation
+//=============================================================================
+
+AudioCache& AudioCache::Instance()
+{
+    static AudioCache s_instance;
+    return s_instance;
+}
+
+AudioCache::AudioCache()
+    : m_hMutex(CreateMutexW(NULL, FALSE, CACHE_MUTEX_NAME))
+    , m_hFile(INVALID_HANDLE_VALUE)
+    , m_hMapping(NULL)
+    , m_view(nullptr)
+    , m_mapFailed(false)
+{
+}
+
+AudioCache::~AudioCache()
+{
+    if (m_view) UnmapViewOfFile(m_view);
+    if (m_hMapping) CloseHandle(m_hMapping);
+    if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle(m_hFile);
+    if (m_hMutex) CloseHandle(m_hMutex);
+}
+
+ULONGLONG AudioCache::MakeKey(const std::wstring& text, const std::string& voiceId)
+{
+    // Trim leading/trailing whitespace so cosmetic differences don't split
+    // the cache
+    size_t begin = text.find_first_not_of(L" \t\r\n");
+    size_t end = text.find_last_not_of(L" \t\r\n");
+    ULONGLONG hash = 0xCBF29CE484222325ULL;  // FNV offset basis
+    if (begin != std::wstring::npos) {
+        hash = HashBytes(hash, text.data() + begin, (end - begin + 1) * sizeof(wchar_t));
+    }
+    hash = HashBytes(hash, "\0", 1);  // Separator so (text, voice) can't collide
+    return HashBytes(hash, voiceId.data(), voiceId.size());
+}
+
+bool AudioCache::EnsureMapped()
+{
+    if (m_view) {
+        return true;
+    }
+    if (m_mapFailed || !m_hMutex) {
+        return false;
+    }
+
+    // Back the mapping with a real file under %LOCALAPPDATA%\VibeVoice so
+    // the cache survives reboots
+    wchar_t path[MAX_PATH] = { 0 };
+    DWORD len = GetEnvironmentVariableW(L"LOCALAPPDATA", path, MAX_PATH);
+    if (len == 0 || len >= MAX_PATH) {
+        m_mapFailed = true;
+        return false;
+    }
+    wcscat_s(path, L"\\VibeVoice");
+    CreateDirectoryW(path, NULL);
+    wcscat_s(path, L"\\");
+    wcscat_s(path, CACHE_FILE_NAME);
+
+    const ULONGLONG totalSize =
+        sizeof(CacheHeader) + MAX_ENTRIES * sizeof(CacheEntry) + ARENA_BYTES;
+
+    m_hFile = CreateFileW(path, GENERIC_READ | GENERIC_WRITE,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE, NULL,
+                          OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_hFile == INVALID_HANDLE_VALUE) {
+        m_mapFailed = true;
+        return false;
+    }
+
+    m_hMapping = CreateFileMappingW(m_hFile, NULL, PAGE_READWRITE,
+                                    static_cast<DWORD>(totalSize >> 32),
+                                    static_cast<DWORD>(totalSize & 0xFFFFFFFF),
+                                    CACHE_MAPPING_NAME);
+    if (!m_hMapping) {
+        m_mapFailed = true;
+        return false;
+    }
+
+    m_view = static_cast<BYTE*>(MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    if (!m_view) {
+        m_mapFailed = true;
+        return false;
+    }
+
+    // First process to map an empty/stale file initializes it
+    CacheHeader* header = GetHeader();
+    if (header->magic != CACHE_MAGIC || header->version != CACHE_VERSION) {
+        memset(m_view, 0, sizeof(CacheHeader) + MAX_ENTRIES * sizeof(CacheEntry));
+        header->magic = CACHE_MAGIC;
+        header->version = CACHE_VERSION;
+    }
+
+    return true;
+}
+
+bool AudioCache::AcquireLock()
+{
+    DWORD wait = WaitForSingleObject(m_hMutex, 100);
+    if (wait == WAIT_OBJECT_0) {
+        return true;
+    }
+
+    // WAIT_ABANDONED grants ownership too: a host process died while
+    // holding the lock. Treating it as a failed acquisition would keep
+    // the mutex owned forever and wedge the shared cache for every
+    // process on the machine (each Lookup/Insert burning the full
+    // timeout). The dead holder may have been mid-Insert, so the index
+    // may reference torn data - drop it; the arena bytes are reclaimed
+    // when the bump allocator wraps.
+    if (wait == WAIT_ABANDONED) {
+        if (EnsureMapped()) {
+            CacheHeader* header = GetHeader();
+            header->entryCount = 0;
+            header->arenaUsed = 0;
+            header->clock = 0;
+        }
+        return true;
+    }
+
+    return false;  // Contended or broken - a miss is always safe
+}
+
+bool AudioCache::Lookup(ULONGLONG key, std::vector<BYTE>& pcm)
+{
+    if (!AcquireLock()) {
+        return false;
+    }
+
+    bool found = false;
+    if (EnsureMapped()) {
+        CacheHeader* header = GetHeader();
+        CacheEntry* entries = GetEntries();
+        for (DWORD i = 0; i < header->entryCount; ++i) {
+            if (entries[i].key == key && entries[i].size > 0) {
+                entries[i].lastUsed = ++header->clock;
+                pcm.resize(entries[i].size);
+                memcpy(pcm.data(), GetArena() + entries[i].offset, entries[i].size);
+                found = true;
+                break;
+            }
+        }
+    }
+
+    ReleaseMutex(m_hMutex);
+    PerfCounters::Instance().RecordCacheLookup(found);
+    return found;
+}
+
+void AudioCache::Insert(ULONGLONG key, const BYTE* pcm, size_t size)
+{
+    if (!pcm || size == 0 || size > MAX_UTTERANCE_BYTES) {
+        return;
+    }
+    if (!AcquireLock()) {
+        return;
+    }
+
+    if (EnsureMapped()) {
+        CacheHeader* header = GetHeader();
+        CacheEntry* entries = GetEntries();
+
+        // Another process may have inserted the same utterance concurrently
+        bool present = false;
+        for (DWORD i = 0; i < header->entryCount; ++i) {
+            if (entries[i].key == key) {
+                present = true;
+                break;
+            }
+        }
+
+        if (!present) {
+            // The arena is bump-allocated; evicted entries leak their bytes
+            // until the arena wraps, at which point it is reset wholesale.
+            // Simple, and the 64 MB arena cycles rarely in practice.
+            if (header->arenaUsed + size > ARENA_BYTES) {
+                header->arenaUsed = 0;
+                header->entryCount = 0;
+            }
+
+            CacheEntry* slot;
+            if (header->entryCount < MAX_ENTRIES) {
+                slot = &entries[header->entryCount++];
+            }
+            else {
+                // Table full - recycle the least recently used entry
+                slot = &entries[0];
+                for (DWORD i = 1; i < MAX_ENTRIES; ++i) {
+                    if (entries[i].lastUsed < slot->lastUsed) {
+                        slot = &entries[i];
+                    }
+                }
+            }
+
+            slot->key = key;
+            slot->lastUsed = ++header->clock;
+            slot->offset = header->arenaUsed;
+            slot->size = static_cast<DWORD>(size);
+            memcpy(GetArena() + slot->offset, pcm, size);
+            header->arenaUsed += size;
+        }
+    }
+
+    ReleaseMutex(m_hMutex);
+}
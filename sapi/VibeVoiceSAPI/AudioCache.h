@@ -0,0 +1,87 @@
+// AudioCache.h
+// Client-side audio cache keyed by (text, voice) with memory-mapped storage
+//
+// Screen readers speak the same UI strings thousands of times a day; every
+// repeat previously paid a full round of GPU diffusion. The cache stores the
+// concatenated PCM of completed utterances in a file-backed memory mapping,
+// so hits bypass the pipe entirely, the contents survive process restarts,
+// and all SAPI host processes on the machine share one copy.
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// AudioCache - Process-shared LRU cache of synthesized PCM
+//-----------------------------------------------------------------------------
+class AudioCache
+{
+public:
+    // Process-wide instance (lives until DLL unload)
+    static AudioCache& Instance();
+
+    // Hash of (trimmed text, voice ID) used as the cache key
+    static ULONGLONG MakeKey(const std::wstring& text, const std::string& voiceId);
+
+    // Copy a cached utterance out. Returns false on miss.
+    bool Lookup(ULONGLONG key, std::vector<BYTE>& pcm);
+
+    // Store a completed utterance. Oversized or empty payloads are ignored.
+    void Insert(ULONGLONG key, const BYTE* pcm, size_t size);
+
+private:
+    AudioCache();
+    ~AudioCache();
+
+    // Lazily open (or create) the backing file and mapping
+    bool EnsureMapped();
+
+    // Take the named mutex, including abandoned-mutex recovery. Returns
+    // false only when ownership was NOT granted (timeout/failure) - an
+    // abandoned wait grants ownership and must still be released.
+    bool AcquireLock();
+
+    // On-disk layout: [CacheHeader][CacheEntry x MAX_ENTRIES][data arena].
+    // All fields little-endian, accessed under the named mutex.
+    struct CacheHeader {
+        DWORD magic;
+        DWORD version;
+        DWORD entryCount;
+        DWORD reserved;
+        ULONGLONG clock;        // Monotonic LRU counter
+        ULONGLONG arenaUsed;    // Bump offset into the data arena
+    };
+
+    struct CacheEntry {
+        ULONGLONG key;
+        ULONGLONG lastUsed;     // Clock value at last hit
+        ULONGLONG offset;       // Into the data arena
+        DWORD size;
+        DWORD reserved;
+    };
+
+    static constexpr DWORD CACHE_MAGIC = 0x43415656;        // 'VVAC'
+    static constexpr DWORD CACHE_VERSION = 1;
+    static constexpr size_t MAX_ENTRIES = 512;
+    static constexpr size_t ARENA_BYTES = 64 * 1024 * 1024; // 64 MB of PCM
+    // ~21s at 24kHz/16-bit - UI strings, not documents
+    static constexpr size_t MAX_UTTERANCE_BYTES = 1024 * 1024;
+
+    CacheHeader* GetHeader() { return reinterpret_cast<CacheHeader*>(m_view); }
+    CacheEntry* GetEntries()
+    {
+        return reinterpret_cast<CacheEntry*>(m_view + sizeof(CacheHeader));
+    }
+    BYTE* GetArena()
+    {
+        return m_view + sizeof(CacheHeader) + MAX_ENTRIES * sizeof(CacheEntry);
+    }
+
+    HANDLE m_hMutex;    // Named - serializes access across processes
+    HANDLE m_hFile;
+    HANDLE m_hMapping;
+    BYTE* m_view;
+    bool m_mapFailed;   // Don't retry a failed mapping on every Speak
+};
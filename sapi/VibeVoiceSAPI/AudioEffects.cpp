@@ -0,0 +1,146 @@
+// AudioEffects.cpp
+// Client-side rate (time-stretch) and volume processing
+
+#include "AudioEffects.h"
+
+#include <emmintrin.h>   // SSE2
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+void RateVolumeProcessor::SetRate(long sapiRate)
+{
+    if (sapiRate < -10) sapiRate = -10;
+    if (sapiRate > 10) sapiRate = 10;
+    float speed = static_cast<float>(pow(3.0, sapiRate / 10.0));
+    // Snap near-unity to exact passthrough so the default rate costs nothing
+    m_speed = (fabs(speed - 1.0f) < 0.01f) ? 1.0f : speed;
+}
+
+void RateVolumeProcessor::SetVolume(USHORT volume)
+{
+    if (volume > 100) volume = 100;
+    m_gain = volume / 100.0f;
+}
+
+void RateVolumeProcessor::Reset()
+{
+    m_primed = false;
+    m_pos = 0.0;
+    m_in.clear();
+}
+
+LONGLONG RateVolumeProcessor::Correlate(const short* a, const short* b)
+{
+    // _mm_madd_epi16 pairs 16-bit products into 32-bit sums; widen to
+    // 64-bit every step so full-scale audio can't overflow the accumulator
+    __m128i acc = _mm_setzero_si128();
+    for (int i = 0; i < HOP; i += 8) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        __m128i prod = _mm_madd_epi16(va, vb);
+        __m128i sign = _mm_srai_epi32(prod, 31);
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(prod, sign));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(prod, sign));
+    }
+    LONGLONG lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+    return lanes[0] + lanes[1];
+}
+
+void RateVolumeProcessor::ApplyGain(short* samples, size_t count) const
+{
+    if (m_gain >= 0.999f) {
+        return;
+    }
+    const __m128 gain = _mm_set1_ps(m_gain);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i*>(samples + i));
+        __m128i sign = _mm_srai_epi16(v, 15);
+        __m128i lo = _mm_unpacklo_epi16(v, sign);
+        __m128i hi = _mm_unpackhi_epi16(v, sign);
+        __m128i rlo = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(lo), gain));
+        __m128i rhi = _mm_cvtps_epi32(_mm_mul_ps(_mm_cvtepi32_ps(hi), gain));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i),
+                         _mm_packs_epi32(rlo, rhi));
+    }
+    for (; i < count; ++i) {
+        samples[i] = static_cast<short>(samples[i] * m_gain);
+    }
+}
+
+const BYTE* RateVolumeProcessor::Process(const BYTE* data, DWORD size, DWORD& outSize)
+{
+    const short* samples = reinterpret_cast<const short*>(data);
+    const size_t count = size / sizeof(short);
+
+    if (m_speed == 1.0f) {
+        if (m_gain >= 0.999f) {
+            outSize = size;  // Both stages idle - hand the chunk back as-is
+            return data;
+        }
+        m_scratch.assign(samples, samples + count);
+        ApplyGain(m_scratch.data(), m_scratch.size());
+        outSize = static_cast<DWORD>(m_scratch.size() * sizeof(short));
+        return reinterpret_cast<const BYTE*>(m_scratch.data());
+    }
+
+    m_in.insert(m_in.end(), samples, samples + count);
+    m_out.clear();
+
+    // First window goes out verbatim and seeds the similarity tail
+    if (!m_primed) {
+        if (m_in.size() < static_cast<size_t>(WINDOW)) {
+            outSize = 0;
+            return data;
+        }
+        m_out.insert(m_out.end(), m_in.begin(), m_in.begin() + HOP);
+        memcpy(m_tail, m_in.data() + HOP, sizeof(m_tail));
+        m_pos = HOP * m_speed;
+        m_primed = true;
+    }
+
+    // Each iteration places one window and emits HOP output samples
+    while (static_cast<size_t>(m_pos) + SEARCH + WINDOW <= m_in.size()) {
+        const int center = static_cast<int>(m_pos);
+        const int dMin = (center >= SEARCH) ? -SEARCH : -center;
+
+        // Find the offset where the input best continues the tail we
+        // already emitted - that alignment makes the cross-fade seamless
+        int bestD = dMin;
+        LONGLONG bestScore = LLONG_MIN;
+        for (int d = dMin; d <= SEARCH; ++d) {
+            LONGLONG score = Correlate(m_tail, m_in.data() + center + d);
+            if (score > bestScore) {
+                bestScore = score;
+                bestD = d;
+            }
+        }
+
+        const short* seg = m_in.data() + center + bestD;
+
+        // Linear cross-fade from the previous window's tail into this one
+        const size_t base = m_out.size();
+        m_out.resize(base + HOP);
+        for (int i = 0; i < HOP; ++i) {
+            int mixed = (m_tail[i] * (HOP - i) + seg[i] * i) / HOP;
+            m_out[base + i] = static_cast<short>(mixed);
+        }
+
+        memcpy(m_tail, seg + HOP, sizeof(m_tail));
+        m_pos += HOP * m_speed;
+    }
+
+    // Drop input the search window can no longer reach
+    const size_t keepFrom =
+        (m_pos > SEARCH) ? static_cast<size_t>(m_pos) - SEARCH : 0;
+    if (keepFrom > 0) {
+        m_in.erase(m_in.begin(), m_in.begin() + keepFrom);
+        m_pos -= static_cast<double>(keepFrom);
+    }
+
+    ApplyGain(m_out.data(), m_out.size());
+    outSize = static_cast<DWORD>(m_out.size() * sizeof(short));
+    return reinterpret_cast<const BYTE*>(m_out.data());
+}
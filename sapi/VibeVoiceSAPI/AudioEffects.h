@@ -0,0 +1,70 @@
+// AudioEffects.h
+// Client-side rate (time-stretch) and volume processing
+//
+// SAPI hosts adjust speech rate and volume at any time - screen-reader
+// users routinely run at 1.5-3x. Re-synthesizing at a different rate would
+// multiply GPU cost per rate notch; instead the DLL applies a WSOLA
+// time-stretch and a gain stage to chunks on their way into
+// ISpTTSEngineSite::Write. Pure client-side DSP, no extra model inference.
+
+#pragma once
+
+#include <windows.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// RateVolumeProcessor - Streaming WSOLA time-stretch + gain (16-bit mono)
+//
+// WSOLA (waveform similarity overlap-add) changes duration without changing
+// pitch: output is assembled from half-overlapping windows of input, each
+// window picked near its nominal position at the offset that best matches
+// the previous window's tail, then cross-faded in. The similarity search is
+// the hot loop and runs on SSE2 (_mm_madd_epi16); the gain stage is also
+// vectorized. At 1.0x speed the search locks onto the exact continuation
+// and the stretch is bit-transparent apart from rounding.
+//-----------------------------------------------------------------------------
+class RateVolumeProcessor
+{
+public:
+    // SAPI rate (-10..10) maps to a speed factor of 3^(rate/10), the
+    // conventional interpretation: +10 is 3x faster, -10 is 3x slower
+    void SetRate(long sapiRate);
+
+    // SAPI volume (0..100) maps to linear gain
+    void SetVolume(USHORT volume);
+
+    // Drop carried state at an utterance boundary
+    void Reset();
+
+    // True when either stage would modify samples
+    bool Active() const { return m_speed != 1.0f || m_gain < 0.999f; }
+
+    // Current playback speed factor (1.0 = unchanged duration)
+    float Speed() const { return m_speed; }
+
+    // Process one chunk of 16-bit mono PCM. Returns a pointer valid until
+    // the next call; outSize shrinks or grows with the rate setting and may
+    // be 0 while the stretcher accumulates enough input for a window.
+    const BYTE* Process(const BYTE* data, DWORD size, DWORD& outSize);
+
+private:
+    // 20ms windows at 24kHz, half-overlapped, with a 5ms similarity search
+    // range on either side of the nominal position
+    static constexpr int WINDOW = 480;
+    static constexpr int HOP = WINDOW / 2;
+    static constexpr int SEARCH = 120;
+
+    // Cross-correlation of two HOP-sample regions (SSE2, 64-bit accumulate)
+    static LONGLONG Correlate(const short* a, const short* b);
+
+    void ApplyGain(short* samples, size_t count) const;
+
+    float m_speed = 1.0f;
+    float m_gain = 1.0f;
+    bool m_primed = false;
+    double m_pos = 0.0;             // Nominal analysis position in m_in
+    short m_tail[HOP] = {};         // Second half of the last window placed
+    std::vector<short> m_in;        // Input samples awaiting stretch
+    std::vector<short> m_out;       // Samples produced by this Process call
+    std::vector<short> m_scratch;   // Gain-only path (input stays const)
+};
@@ -0,0 +1,585 @@
+// Benchmark.cpp
+// Console benchmark harness for the VibeVoice SAPI bridge
+//
+// Exercises both layers of the stack so a regression can be localized
+// before it ships:
+//
+//   raw   - PipeClient::StreamTTS straight against the server, bypassing
+//           SAPI entirely. Isolates server + transport performance.
+//   sapi  - the full registered COM engine via ISpVoice, with output
+//           captured by a timing stream. Adds text extraction,
+//           normalization, sentence pipelining, DSP and event dispatch.
+//
+// Workloads:
+//   burst       - N short utterances back to back (screen-reader shape)
+//   document    - one long multi-sentence text (narration shape)
+//   concurrent  - T threads, each its own connection, bursting in parallel
+//   abort       - cancel mid-stream and measure cancel-to-return latency
+//
+// Reported per workload: time-to-first-audio and total latency at
+// p50/p95/p99, plus the real-time factor (seconds of audio produced per
+// wall second - above 1.0 means faster than playback).
+//
+// Run before every server or DLL upgrade:
+//   Benchmark.exe --mode all --count 50
+//   Benchmark.exe --mode concurrent --threads 4 --count 20
+//   Benchmark.exe --mode burst --endpoint tcp://gpubox:9700
+
+#include "..\VibeVoiceSAPI.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cwchar>
+
+//-----------------------------------------------------------------------------
+// Sample texts
+//-----------------------------------------------------------------------------
+
+// Short-utterance pool, cycled by the burst workloads. Varied lengths so
+// the cache can't serve every iteration from one entry.
+static const wchar_t* kShortTexts[] = {
+    L"Settings window opened.",
+    L"You have three unread messages in your inbox today.",
+    L"Battery at twenty percent, consider plugging in soon.",
+    L"File saved successfully.",
+    L"The meeting starts in fifteen minutes in conference room four.",
+    L"Download complete.",
+    L"Seven new results were found for your search query.",
+    L"Volume set to sixty percent.",
+};
+
+// One paragraph of the document workload; repeated to the requested length
+static const wchar_t kParagraph[] =
+    L"The quick brown fox jumps over the lazy dog while the narrator reads "
+    L"on at a steady pace, sentence after sentence, so the pipeline has to "
+    L"sustain generation well past the first chunk. Long form synthesis "
+    L"exercises the prefetch path, the flow control window, and the ring "
+    L"between the reader and the audio device. ";
+
+//-----------------------------------------------------------------------------
+// Stats - collect per-utterance samples, report percentiles
+//-----------------------------------------------------------------------------
+struct Stats
+{
+    std::vector<double> samples;
+
+    void Add(double v) { samples.push_back(v); }
+
+    double Percentile(double p) const
+    {
+        if (samples.empty()) {
+            return 0.0;
+        }
+        std::vector<double> sorted(samples);
+        std::sort(sorted.begin(), sorted.end());
+        size_t idx = static_cast<size_t>(p / 100.0 * (sorted.size() - 1) + 0.5);
+        return sorted[idx];
+    }
+};
+
+static void PrintLatencyRow(const wchar_t* label, const Stats& s)
+{
+    wprintf(L"  %-18s p50 %7.1f ms   p95 %7.1f ms   p99 %7.1f ms   (n=%zu)\n",
+            label, s.Percentile(50), s.Percentile(95), s.Percentile(99),
+            s.samples.size());
+}
+
+//-----------------------------------------------------------------------------
+// Raw layer - PipeClient::StreamTTS
+//-----------------------------------------------------------------------------
+
+struct RawContext
+{
+    ULONGLONG startTick = 0;
+    ULONGLONG firstChunkTick = 0;   // 0 until the first chunk lands
+    ULONGLONG bytes = 0;
+    volatile bool cancel = false;
+};
+
+static void RawChunkCallback(const BYTE* /*data*/, DWORD size, void* context)
+{
+    RawContext* ctx = static_cast<RawContext*>(context);
+    if (ctx->firstChunkTick == 0) {
+        ctx->firstChunkTick = GetTickCount64();
+    }
+    ctx->bytes += size;
+}
+
+// One utterance through StreamTTS. Returns S_OK and fills the stats on
+// success; failures are counted by the caller.
+static HRESULT RunRawUtterance(PipeClient& client, const std::wstring& text,
+                               const std::string& voiceId, Stats& ttfa,
+                               Stats& total, double& audioSeconds,
+                               double& wallSeconds)
+{
+    RawContext ctx;
+    ctx.startTick = GetTickCount64();
+    HRESULT hr = client.StreamTTS(text.c_str(), voiceId.c_str(),
+                                  RawChunkCallback, &ctx, &ctx.cancel);
+    ULONGLONG endTick = GetTickCount64();
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    if (ctx.firstChunkTick != 0) {
+        ttfa.Add(static_cast<double>(ctx.firstChunkTick - ctx.startTick));
+    }
+    total.Add(static_cast<double>(endTick - ctx.startTick));
+    audioSeconds += ctx.bytes / double(SAMPLE_RATE * 2);
+    wallSeconds += (endTick - ctx.startTick) / 1000.0;
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+// TimingStream - ISpStreamFormat sink for the SAPI layer
+//
+// ISpVoice::SetOutput wants somewhere to put the audio; a file or the
+// device would add its own latency to the measurement. This stream
+// swallows the PCM and records the tick of the first Write, which is the
+// engine's first-audio moment as the host experiences it.
+//-----------------------------------------------------------------------------
+class TimingStream : public ISpStreamFormat
+{
+public:
+    ULONGLONG firstWriteTick = 0;
+    ULONGLONG bytes = 0;
+
+    void Reset()
+    {
+        firstWriteTick = 0;
+        bytes = 0;
+    }
+
+    // IUnknown
+    STDMETHODIMP QueryInterface(REFIID riid, void** ppv) override
+    {
+        if (riid == IID_IUnknown || riid == IID_ISequentialStream ||
+            riid == IID_IStream || riid == IID_ISpStreamFormat) {
+            *ppv = static_cast<ISpStreamFormat*>(this);
+            AddRef();
+            return S_OK;
+        }
+        *ppv = nullptr;
+        return E_NOINTERFACE;
+    }
+    STDMETHODIMP_(ULONG) AddRef() override
+    {
+        return InterlockedIncrement(&m_ref);
+    }
+    STDMETHODIMP_(ULONG) Release() override
+    {
+        ULONG ref = InterlockedDecrement(&m_ref);
+        if (ref == 0) {
+            delete this;
+        }
+        return ref;
+    }
+
+    // ISequentialStream
+    STDMETHODIMP Read(void* /*pv*/, ULONG /*cb*/, ULONG* pcbRead) override
+    {
+        if (pcbRead) {
+            *pcbRead = 0;
+        }
+        return S_FALSE;
+    }
+    STDMETHODIMP Write(const void* /*pv*/, ULONG cb, ULONG* pcbWritten) override
+    {
+        if (firstWriteTick == 0) {
+            firstWriteTick = GetTickCount64();
+        }
+        bytes += cb;
+        if (pcbWritten) {
+            *pcbWritten = cb;
+        }
+        return S_OK;
+    }
+
+    // IStream - SAPI probes position occasionally; everything else is
+    // irrelevant for a write-only sink
+    STDMETHODIMP Seek(LARGE_INTEGER, DWORD, ULARGE_INTEGER* plibNewPosition) override
+    {
+        if (plibNewPosition) {
+            plibNewPosition->QuadPart = bytes;
+        }
+        return S_OK;
+    }
+    STDMETHODIMP SetSize(ULARGE_INTEGER) override { return E_NOTIMPL; }
+    STDMETHODIMP CopyTo(IStream*, ULARGE_INTEGER, ULARGE_INTEGER*,
+                        ULARGE_INTEGER*) override { return E_NOTIMPL; }
+    STDMETHODIMP Commit(DWORD) override { return S_OK; }
+    STDMETHODIMP Revert() override { return E_NOTIMPL; }
+    STDMETHODIMP LockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override
+    {
+        return E_NOTIMPL;
+    }
+    STDMETHODIMP UnlockRegion(ULARGE_INTEGER, ULARGE_INTEGER, DWORD) override
+    {
+        return E_NOTIMPL;
+    }
+    STDMETHODIMP Stat(STATSTG* pstatstg, DWORD) override
+    {
+        if (!pstatstg) {
+            return E_POINTER;
+        }
+        memset(pstatstg, 0, sizeof(*pstatstg));
+        pstatstg->cbSize.QuadPart = bytes;
+        return S_OK;
+    }
+    STDMETHODIMP Clone(IStream**) override { return E_NOTIMPL; }
+
+    // ISpStreamFormat - native engine format, so no converter sits between
+    // the engine and this sink
+    STDMETHODIMP GetFormat(GUID* pguidFormatId,
+                           WAVEFORMATEX** ppCoMemWaveFormatEx) override
+    {
+        if (!pguidFormatId || !ppCoMemWaveFormatEx) {
+            return E_POINTER;
+        }
+        *pguidFormatId = SPDFID_WaveFormatEx;
+        WAVEFORMATEX* wfx = static_cast<WAVEFORMATEX*>(
+            CoTaskMemAlloc(sizeof(WAVEFORMATEX)));
+        if (!wfx) {
+            return E_OUTOFMEMORY;
+        }
+        wfx->wFormatTag = WAVE_FORMAT_PCM;
+        wfx->nChannels = NUM_CHANNELS;
+        wfx->nSamplesPerSec = SAMPLE_RATE;
+        wfx->wBitsPerSample = BITS_PER_SAMPLE;
+        wfx->nBlockAlign = NUM_CHANNELS * BITS_PER_SAMPLE / 8;
+        wfx->nAvgBytesPerSec = SAMPLE_RATE * wfx->nBlockAlign;
+        wfx->cbSize = 0;
+        *ppCoMemWaveFormatEx = wfx;
+        return S_OK;
+    }
+
+private:
+    LONG m_ref = 1;
+};
+
+// Find the first registered voice token whose description mentions
+// VibeVoice, or one matching the requested name
+static HRESULT FindVibeVoiceToken(const std::wstring& nameHint,
+                                  ISpObjectToken** ppToken)
+{
+    CComPtr<IEnumSpObjectTokens> cpEnum;
+    HRESULT hr = SpEnumTokens(SPCAT_VOICES, NULL, NULL, &cpEnum);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    CComPtr<ISpObjectToken> cpToken;
+    while (cpEnum->Next(1, &cpToken, NULL) == S_OK) {
+        CSpDynamicString dstrDesc;
+        if (SUCCEEDED(SpGetDescription(cpToken, &dstrDesc))) {
+            if (wcsstr(dstrDesc, L"VibeVoice") &&
+                (nameHint.empty() || wcsstr(dstrDesc, nameHint.c_str()))) {
+                *ppToken = cpToken.Detach();
+                return S_OK;
+            }
+        }
+        cpToken.Release();
+    }
+    return SPERR_NOT_FOUND;
+}
+
+//-----------------------------------------------------------------------------
+// Workloads
+//-----------------------------------------------------------------------------
+
+struct Options
+{
+    std::wstring mode = L"all";
+    std::string voiceId = "en-Carter_man";
+    std::wstring sapiVoice;         // Description substring, e.g. "Carter"
+    int count = 20;
+    int threads = 4;
+    int documentRepeats = 6;        // Paragraphs per document utterance
+};
+
+static void ReportRtf(double audioSeconds, double wallSeconds)
+{
+    if (wallSeconds > 0.0) {
+        wprintf(L"  %-18s %.2fx  (%.1f s audio in %.1f s wall)\n",
+                L"real-time factor", audioSeconds / wallSeconds, audioSeconds,
+                wallSeconds);
+    }
+}
+
+static void RunRawBurst(const Options& opt)
+{
+    wprintf(L"\n[raw burst] %d short utterances, voice %hs\n", opt.count,
+            opt.voiceId.c_str());
+    PipeClient client;
+    Stats ttfa, total;
+    double audioSeconds = 0.0, wallSeconds = 0.0;
+    int failures = 0;
+    for (int i = 0; i < opt.count; ++i) {
+        const wchar_t* text =
+            kShortTexts[i % (sizeof(kShortTexts) / sizeof(kShortTexts[0]))];
+        if (FAILED(RunRawUtterance(client, text, opt.voiceId, ttfa, total,
+                                   audioSeconds, wallSeconds))) {
+            ++failures;
+        }
+    }
+    PrintLatencyRow(L"first audio", ttfa);
+    PrintLatencyRow(L"total", total);
+    ReportRtf(audioSeconds, wallSeconds);
+    if (failures) {
+        wprintf(L"  FAILURES: %d of %d\n", failures, opt.count);
+    }
+}
+
+static void RunRawDocument(const Options& opt)
+{
+    std::wstring document;
+    for (int i = 0; i < opt.documentRepeats; ++i) {
+        document += kParagraph;
+    }
+    wprintf(L"\n[raw document] %d x %zu chars, voice %hs\n", opt.count / 4 + 1,
+            document.size(), opt.voiceId.c_str());
+    PipeClient client;
+    Stats ttfa, total;
+    double audioSeconds = 0.0, wallSeconds = 0.0;
+    int failures = 0;
+    int runs = opt.count / 4 + 1;   // Documents are long; fewer iterations
+    for (int i = 0; i < runs; ++i) {
+        if (FAILED(RunRawUtterance(client, document, opt.voiceId, ttfa, total,
+                                   audioSeconds, wallSeconds))) {
+            ++failures;
+        }
+    }
+    PrintLatencyRow(L"first audio", ttfa);
+    PrintLatencyRow(L"total", total);
+    ReportRtf(audioSeconds, wallSeconds);
+    if (failures) {
+        wprintf(L"  FAILURES: %d of %d\n", failures, runs);
+    }
+}
+
+static void RunRawConcurrent(const Options& opt)
+{
+    wprintf(L"\n[raw concurrent] %d threads x %d utterances, voice %hs\n",
+            opt.threads, opt.count, opt.voiceId.c_str());
+    std::mutex statsMutex;
+    Stats ttfa, total;
+    double audioSeconds = 0.0, wallSeconds = 0.0;
+    int failures = 0;
+
+    ULONGLONG wallStart = GetTickCount64();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < opt.threads; ++t) {
+        workers.emplace_back([&, t]() {
+            // Each worker owns a connection, like each pooled engine does
+            PipeClient client;
+            Stats localTtfa, localTotal;
+            double localAudio = 0.0, localWall = 0.0;
+            int localFailures = 0;
+            for (int i = 0; i < opt.count; ++i) {
+                const wchar_t* text = kShortTexts[
+                    (t + i) % (sizeof(kShortTexts) / sizeof(kShortTexts[0]))];
+                if (FAILED(RunRawUtterance(client, text, opt.voiceId,
+                                           localTtfa, localTotal, localAudio,
+                                           localWall))) {
+                    ++localFailures;
+                }
+            }
+            std::lock_guard<std::mutex> lock(statsMutex);
+            ttfa.samples.insert(ttfa.samples.end(), localTtfa.samples.begin(),
+                                localTtfa.samples.end());
+            total.samples.insert(total.samples.end(),
+                                 localTotal.samples.begin(),
+                                 localTotal.samples.end());
+            audioSeconds += localAudio;
+            failures += localFailures;
+        });
+    }
+    for (std::thread& w : workers) {
+        w.join();
+    }
+    wallSeconds = (GetTickCount64() - wallStart) / 1000.0;
+
+    PrintLatencyRow(L"first audio", ttfa);
+    PrintLatencyRow(L"total", total);
+    ReportRtf(audioSeconds, wallSeconds);
+    if (failures) {
+        wprintf(L"  FAILURES: %d of %d\n", failures,
+                opt.threads * opt.count);
+    }
+}
+
+static void RunRawAbortStorm(const Options& opt)
+{
+    wprintf(L"\n[raw abort] %d utterances cancelled mid-stream, voice %hs\n",
+            opt.count, opt.voiceId.c_str());
+    PipeClient client;
+    std::wstring document;
+    for (int i = 0; i < opt.documentRepeats; ++i) {
+        document += kParagraph;     // Long enough to still be streaming
+    }
+
+    Stats cancelLatency;
+    int failures = 0;
+    for (int i = 0; i < opt.count; ++i) {
+        RawContext ctx;
+        ctx.startTick = GetTickCount64();
+        volatile ULONGLONG cancelTick = 0;
+        // Pull the plug shortly after first audio, mid-generation
+        std::thread killer([&]() {
+            Sleep(400);
+            cancelTick = GetTickCount64();
+            ctx.cancel = true;
+        });
+        HRESULT hr = client.StreamTTS(document.c_str(), opt.voiceId.c_str(),
+                                      RawChunkCallback, &ctx, &ctx.cancel);
+        ULONGLONG endTick = GetTickCount64();
+        killer.join();
+        // E_ABORT is the expected outcome; S_OK means the stream outran
+        // the timer (server unusually fast or text too short)
+        if (hr != E_ABORT && FAILED(hr)) {
+            ++failures;
+        }
+        else if (cancelTick != 0 && endTick >= cancelTick) {
+            cancelLatency.Add(static_cast<double>(endTick - cancelTick));
+        }
+    }
+    PrintLatencyRow(L"cancel-to-return", cancelLatency);
+    if (failures) {
+        wprintf(L"  FAILURES: %d of %d\n", failures, opt.count);
+    }
+}
+
+static void RunSapiBurst(const Options& opt)
+{
+    wprintf(L"\n[sapi burst] %d short utterances via ISpVoice\n", opt.count);
+
+    CComPtr<ISpVoice> cpVoice;
+    HRESULT hr = cpVoice.CoCreateInstance(CLSID_SpVoice);
+    if (FAILED(hr)) {
+        wprintf(L"  SKIPPED: SpVoice creation failed (0x%08X)\n", hr);
+        return;
+    }
+    CComPtr<ISpObjectToken> cpToken;
+    hr = FindVibeVoiceToken(opt.sapiVoice, &cpToken);
+    if (FAILED(hr)) {
+        wprintf(L"  SKIPPED: no VibeVoice voice registered (run "
+                L"install.bat first)\n");
+        return;
+    }
+    cpVoice->SetVoice(cpToken);
+
+    TimingStream* sink = new TimingStream();
+    hr = cpVoice->SetOutput(sink, FALSE);
+    if (FAILED(hr)) {
+        wprintf(L"  SKIPPED: SetOutput failed (0x%08X)\n", hr);
+        sink->Release();
+        return;
+    }
+
+    Stats ttfa, total;
+    double audioSeconds = 0.0, wallSeconds = 0.0;
+    int failures = 0;
+    for (int i = 0; i < opt.count; ++i) {
+        const wchar_t* text =
+            kShortTexts[i % (sizeof(kShortTexts) / sizeof(kShortTexts[0]))];
+        sink->Reset();
+        ULONGLONG startTick = GetTickCount64();
+        hr = cpVoice->Speak(text, SPF_DEFAULT, NULL);
+        ULONGLONG endTick = GetTickCount64();
+        if (FAILED(hr)) {
+            ++failures;
+            continue;
+        }
+        if (sink->firstWriteTick != 0) {
+            ttfa.Add(static_cast<double>(sink->firstWriteTick - startTick));
+        }
+        total.Add(static_cast<double>(endTick - startTick));
+        audioSeconds += sink->bytes / double(SAMPLE_RATE * 2);
+        wallSeconds += (endTick - startTick) / 1000.0;
+    }
+    PrintLatencyRow(L"first audio", ttfa);
+    PrintLatencyRow(L"total", total);
+    ReportRtf(audioSeconds, wallSeconds);
+    if (failures) {
+        wprintf(L"  FAILURES: %d of %d\n", failures, opt.count);
+    }
+    sink->Release();
+}
+
+//-----------------------------------------------------------------------------
+// Entry point
+//-----------------------------------------------------------------------------
+
+static void Usage()
+{
+    wprintf(
+        L"Usage: Benchmark.exe [options]\n"
+        L"  --mode M       burst | document | concurrent | abort | sapi | all\n"
+        L"  --count N      utterances per workload (default 20)\n"
+        L"  --threads T    workers for the concurrent workload (default 4)\n"
+        L"  --voice ID     server voice ID (default en-Carter_man)\n"
+        L"  --sapi-voice S registered voice name substring for the sapi mode\n"
+        L"  --endpoint E   pipe path or tcp://host:port (default local pipe)\n");
+}
+
+int wmain(int argc, wchar_t* argv[])
+{
+    Options opt;
+    for (int i = 1; i < argc; ++i) {
+        std::wstring arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == L"--mode" && hasValue) {
+            opt.mode = argv[++i];
+        }
+        else if (arg == L"--count" && hasValue) {
+            opt.count = _wtoi(argv[++i]);
+        }
+        else if (arg == L"--threads" && hasValue) {
+            opt.threads = _wtoi(argv[++i]);
+        }
+        else if (arg == L"--voice" && hasValue) {
+            std::wstring wide = argv[++i];
+            opt.voiceId.assign(wide.begin(), wide.end());
+        }
+        else if (arg == L"--sapi-voice" && hasValue) {
+            opt.sapiVoice = argv[++i];
+        }
+        else if (arg == L"--endpoint" && hasValue) {
+            PipeClient::SetEndpoint(argv[++i]);
+        }
+        else {
+            Usage();
+            return 1;
+        }
+    }
+    if (opt.count < 1 || opt.threads < 1) {
+        Usage();
+        return 1;
+    }
+
+    HRESULT hr = CoInitializeEx(NULL, COINIT_MULTITHREADED);
+    if (FAILED(hr)) {
+        wprintf(L"CoInitializeEx failed (0x%08X)\n", hr);
+        return 1;
+    }
+
+    const bool all = opt.mode == L"all";
+    if (all || opt.mode == L"burst") {
+        RunRawBurst(opt);
+    }
+    if (all || opt.mode == L"document") {
+        RunRawDocument(opt);
+    }
+    if (all || opt.mode == L"concurrent") {
+        RunRawConcurrent(opt);
+    }
+    if (all || opt.mode == L"abort") {
+        RunRawAbortStorm(opt);
+    }
+    if (all || opt.mode == L"sapi") {
+        RunSapiBurst(opt);
+    }
+
+    CoUninitialize();
+    return 0;
+}
@@ -0,0 +1,76 @@
+// ConnectionManager.cpp
+// Process-wide pool of pipe connections shared by all engine instances
+
+#include "VibeVoiceSAPI.h"
+#include "ConnectionManager.h"
+
+//=============================================================================
+// ConnectionManager Implementation
+//=============================================================================
+
+ConnectionManager& ConnectionManager::Instance()
+{
+    // Constructed on first use, destroyed at DLL unload
+    static ConnectionManager s_instance;
+    return s_instance;
+}
+
+ConnectionManager::Lease ConnectionManager::Acquire()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Prefer an idle connection that is already open - reusing it skips
+    // the connect handshake entirely.
+    Entry* idleUnconnected = nullptr;
+    for (auto& entry : m_pool) {
+        if (entry.activeLeases > 0) {
+            continue;
+        }
+        if (entry.client->IsConnected()) {
+            entry.activeLeases = 1;
+            return Lease(this, entry.client.get());
+        }
+        idleUnconnected = &entry;
+    }
+
+    if (idleUnconnected) {
+        idleUnconnected->activeLeases = 1;
+        return Lease(this, idleUnconnected->client.get());
+    }
+
+    // Grow the pool rather than sharing, up to the cap
+    if (m_pool.size() < MAX_CONNECTIONS) {
+        m_pool.push_back(Entry{ std::make_unique<PipeClient>(), 1 });
+        return Lease(this, m_pool.back().client.get());
+    }
+
+    // Every connection is busy. PipeClient multiplexes requests by ID, so
+    // rather than queueing, pile onto the least-loaded connection and let
+    // the streams interleave.
+    Entry* least = &m_pool[0];
+    for (auto& entry : m_pool) {
+        if (entry.activeLeases < least->activeLeases) {
+            least = &entry;
+        }
+    }
+    ++least->activeLeases;
+    return Lease(this, least->client.get());
+}
+
+void ConnectionManager::Release(PipeClient* client)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto& entry : m_pool) {
+        if (entry.client.get() == client) {
+            --entry.activeLeases;
+            break;
+        }
+    }
+}
+
+ConnectionManager::Lease::~Lease()
+{
+    if (m_owner && m_client) {
+        m_owner->Release(m_client);
+    }
+}
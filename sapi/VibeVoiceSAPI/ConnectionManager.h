@@ -0,0 +1,77 @@
+// ConnectionManager.h
+// Process-wide pool of pipe connections shared by all engine instances
+//
+// SAPI creates a CVibeVoiceTTSEngine per voice token and per application, so
+// a process can easily hold many engine objects. Giving each one its own
+// PipeClient multiplies connections and serializes them on the server's
+// accept path. Instead, all engines in the process share a small pool of
+// persistent connections, handed out per request.
+
+#pragma once
+
+#include <windows.h>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class PipeClient;
+
+//-----------------------------------------------------------------------------
+// ConnectionManager - Singleton pool of PipeClient connections
+//-----------------------------------------------------------------------------
+class ConnectionManager
+{
+public:
+    // Process-wide instance (lives until DLL unload)
+    static ConnectionManager& Instance();
+
+    // RAII lease on a pooled connection. The connection is returned to the
+    // pool (still open) when the lease goes out of scope.
+    class Lease
+    {
+    public:
+        Lease(ConnectionManager* owner, PipeClient* client)
+            : m_owner(owner), m_client(client) {}
+        ~Lease();
+
+        Lease(Lease&& other) noexcept
+            : m_owner(other.m_owner), m_client(other.m_client)
+        {
+            other.m_owner = nullptr;
+            other.m_client = nullptr;
+        }
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        PipeClient* operator->() { return m_client; }
+        PipeClient* Get() { return m_client; }
+
+    private:
+        ConnectionManager* m_owner;
+        PipeClient* m_client;
+    };
+
+    // Borrow a connection. Prefers an idle already-connected client and
+    // grows the pool up to MAX_CONNECTIONS. Beyond that the protocol's
+    // request multiplexing kicks in: the least-loaded connection is shared,
+    // so concurrent Speak calls never block on each other or on a connect.
+    Lease Acquire();
+
+private:
+    ConnectionManager() = default;
+    ~ConnectionManager() = default;
+
+    void Release(PipeClient* client);
+
+    // Small pool: enough for a few concurrent voices without flooding the
+    // server's accept loop.
+    static constexpr size_t MAX_CONNECTIONS = 4;
+
+    struct Entry {
+        std::unique_ptr<PipeClient> client;
+        int activeLeases = 0;
+    };
+
+    std::mutex m_mutex;
+    std::vector<Entry> m_pool;
+};
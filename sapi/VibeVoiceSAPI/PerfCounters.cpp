@@ -0,0 +1,143 @@
+// PerfCounters.cpp
+// Always-on aggregate performance counters
+
+#include "VibeVoiceSAPI.h"
+#include "PerfCounters.h"
+
+namespace {
+
+// Session-local like the audio cache: every SAPI host in the session
+// shares one block, and the monitoring agent maps the same name
+constexpr wchar_t STATS_MAPPING_NAME[] = L"Local\\VibeVoiceSAPI.Stats";
+
+constexpr DWORD STATS_MAGIC = 0x56565354;   // 'VVST'
+constexpr DWORD STATS_VERSION = 1;
+
+// Field indexes into SharedBlock::counters, mirroring VIBEVOICE_STATS
+enum StatField
+{
+    FIELD_REQUESTS = 0,
+    FIELD_FAILURES,
+    FIELD_ABORTS,
+    FIELD_CACHE_HITS,
+    FIELD_CACHE_MISSES,
+    FIELD_CONNECTS,
+    FIELD_BYTES_STREAMED,
+    FIELD_TTFA_TOTAL_MS,
+    FIELD_TTFA_MAX_MS,
+    FIELD_TTFA_COUNT,
+    FIELD_COUNT
+};
+
+static_assert(FIELD_COUNT == sizeof(VIBEVOICE_STATS) / sizeof(ULONGLONG),
+              "Field enum out of sync with VIBEVOICE_STATS");
+
+}  // namespace
+
+//=============================================================================
+// PerfCounters Implementation
+//=============================================================================
+
+PerfCounters& PerfCounters::Instance()
+{
+    // Constructed on first use, destroyed at DLL unload
+    static PerfCounters s_instance;
+    return s_instance;
+}
+
+PerfCounters::PerfCounters()
+{
+    // Create-or-open: the first process in the session creates the block
+    // (CreateFileMapping hands back the existing section to everyone
+    // else). Failure just downgrades to a process-local block - counting
+    // never breaks speech.
+    m_block = &m_local;
+    m_hMapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL,
+                                    PAGE_READWRITE, 0, sizeof(SharedBlock),
+                                    STATS_MAPPING_NAME);
+    if (!m_hMapping) {
+        return;
+    }
+    bool fresh = (GetLastError() != ERROR_ALREADY_EXISTS);
+
+    void* view = MapViewOfFile(m_hMapping, FILE_MAP_ALL_ACCESS, 0, 0,
+                               sizeof(SharedBlock));
+    if (!view) {
+        CloseHandle(m_hMapping);
+        m_hMapping = nullptr;
+        return;
+    }
+    m_block = static_cast<SharedBlock*>(view);
+
+    // A fresh section arrives zeroed; stamping the header last means a
+    // concurrent opener that races the creator sees either zeros (fine -
+    // the counters are already valid zeros) or the finished header
+    if (fresh) {
+        m_block->version = STATS_VERSION;
+        InterlockedExchange(reinterpret_cast<volatile LONG*>(&m_block->magic),
+                            STATS_MAGIC);
+    }
+}
+
+void PerfCounters::RecordRequest(HRESULT hr, ULONGLONG bytes,
+                                 ULONGLONG ttfaMs, bool sawFirstAudio)
+{
+    if (hr == S_OK) {
+        InterlockedIncrement64(Counter(FIELD_REQUESTS));
+    }
+    else if (hr == E_ABORT) {
+        InterlockedIncrement64(Counter(FIELD_ABORTS));
+    }
+    else {
+        InterlockedIncrement64(Counter(FIELD_FAILURES));
+    }
+
+    if (bytes) {
+        InterlockedExchangeAdd64(Counter(FIELD_BYTES_STREAMED),
+                                 static_cast<LONG64>(bytes));
+    }
+
+    if (sawFirstAudio) {
+        InterlockedExchangeAdd64(Counter(FIELD_TTFA_TOTAL_MS),
+                                 static_cast<LONG64>(ttfaMs));
+        InterlockedIncrement64(Counter(FIELD_TTFA_COUNT));
+
+        // Monotonic max via CAS; contention here is a few engines
+        // finishing requests simultaneously, so the loop is short
+        LONG64* maxSlot = Counter(FIELD_TTFA_MAX_MS);
+        LONG64 seen = *maxSlot;
+        while (static_cast<LONG64>(ttfaMs) > seen &&
+               InterlockedCompareExchange64(maxSlot,
+                                            static_cast<LONG64>(ttfaMs),
+                                            seen) != seen) {
+            seen = *maxSlot;
+        }
+    }
+}
+
+void PerfCounters::RecordCacheLookup(bool hit)
+{
+    InterlockedIncrement64(Counter(hit ? FIELD_CACHE_HITS
+                                       : FIELD_CACHE_MISSES));
+}
+
+void PerfCounters::RecordConnect()
+{
+    InterlockedIncrement64(Counter(FIELD_CONNECTS));
+}
+
+void PerfCounters::Snapshot(VIBEVOICE_STATS& out)
+{
+    ULONGLONG* fields = reinterpret_cast<ULONGLONG*>(&out);
+    for (size_t i = 0; i < FIELD_COUNT; ++i) {
+        fields[i] = static_cast<ULONGLONG>(
+            InterlockedCompareExchange64(Counter(i), 0, 0));
+    }
+}
+
+void PerfCounters::Reset()
+{
+    for (size_t i = 0; i < FIELD_COUNT; ++i) {
+        InterlockedExchange64(Counter(i), 0);
+    }
+}
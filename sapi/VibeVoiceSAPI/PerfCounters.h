@@ -0,0 +1,92 @@
+// PerfCounters.h
+// Always-on aggregate performance counters
+//
+// ETW tracing (Trace.h) is for deep dives; operations also needs numbers
+// that are simply always there: how many utterances this box served, how
+// often the cache saved a synthesis, how often users aborted, and what
+// time-to-first-audio looked like - cheap enough to leave running on
+// every kiosk and poll from a monitoring agent.
+//
+// The counters live in a named shared-memory section, so every SAPI host
+// process in the session updates the same block and the agent reads the
+// fleet-relevant aggregate by mapping the section - no COM activation,
+// no tracer attach. Updates are single interlocked adds (a CAS loop only
+// for the max), so the audio path is unaffected.
+//
+// The same snapshot is also queryable in-process through IVibeVoiceStats,
+// a custom interface on the engine COM object, for agents that already
+// hold an engine instance.
+
+#pragma once
+
+#include <windows.h>
+#include <unknwn.h>
+
+// Snapshot layout - also the wire format of the shared section (after the
+// magic/version header), so it only ever grows at the end
+#pragma pack(push, 8)
+struct VIBEVOICE_STATS
+{
+    ULONGLONG requests;         // Utterance requests completed successfully
+    ULONGLONG failures;         // Requests failed (server/transport errors)
+    ULONGLONG aborts;           // Requests cancelled by the host
+    ULONGLONG cacheHits;        // Audio cache lookups served from memory
+    ULONGLONG cacheMisses;
+    ULONGLONG connects;         // Successful connects (includes reconnects)
+    ULONGLONG bytesStreamed;    // PCM bytes delivered from the server
+    ULONGLONG ttfaTotalMs;      // Sum of per-request time-to-first-audio
+    ULONGLONG ttfaMaxMs;        // Worst time-to-first-audio seen
+    ULONGLONG ttfaCount;        // Requests contributing to the TTFA sums
+};
+#pragma pack(pop)
+
+// Queryable stats on CVibeVoiceTTSEngine. Mean TTFA is ttfaTotalMs /
+// ttfaCount on the caller's side; hit rate is cacheHits / (hits+misses).
+MIDL_INTERFACE("c4e8a7b1-3f52-4d96-8a1e-5b0c9d27e6f3")
+IVibeVoiceStats : public IUnknown
+{
+    virtual HRESULT STDMETHODCALLTYPE GetStats(VIBEVOICE_STATS* pStats) = 0;
+    virtual HRESULT STDMETHODCALLTYPE ResetStats() = 0;
+};
+
+//-----------------------------------------------------------------------------
+// PerfCounters - Singleton over the shared counter block
+//-----------------------------------------------------------------------------
+class PerfCounters
+{
+public:
+    // Process-wide instance (lives until DLL unload)
+    static PerfCounters& Instance();
+
+    // One finished utterance request: outcome, bytes received, and - when
+    // first audio arrived at all - its time-to-first-audio
+    void RecordRequest(HRESULT hr, ULONGLONG bytes, ULONGLONG ttfaMs,
+                       bool sawFirstAudio);
+
+    void RecordCacheLookup(bool hit);
+    void RecordConnect();
+
+    // Consistent-enough copy for reporting (counters keep moving; exact
+    // cross-field consistency is not worth a lock on the update path)
+    void Snapshot(VIBEVOICE_STATS& out);
+    void Reset();
+
+private:
+    PerfCounters();
+    ~PerfCounters() = default;
+
+    // Shared section layout: header then one LONG64 per VIBEVOICE_STATS
+    // field, updated with interlocked ops (valid cross-process)
+    struct SharedBlock
+    {
+        DWORD magic;
+        DWORD version;
+        volatile LONG64 counters[sizeof(VIBEVOICE_STATS) / sizeof(ULONGLONG)];
+    };
+
+    LONG64* Counter(size_t field) { return const_cast<LONG64*>(&m_block->counters[field]); }
+
+    HANDLE m_hMapping = nullptr;
+    SharedBlock* m_block = nullptr;     // Mapped view, or m_local below
+    SharedBlock m_local = {};           // Fallback when mapping fails
+};
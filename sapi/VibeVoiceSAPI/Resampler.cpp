@@ -0,0 +1,182 @@
+// Resampler.cpp
+// SIMD polyphase resampler for native output-format negotiation
+
+#include "Resampler.h"
+
+#include <emmintrin.h>   // SSE2
+#include <immintrin.h>   // AVX2 (runtime-dispatched; safe to include always)
+#include <intrin.h>
+#include <cmath>
+
+namespace {
+
+// Rates SAPI hosts commonly request. Anything else falls back to the engine's
+// native 24kHz and SAPI's own converter.
+constexpr DWORD SUPPORTED_RATES[] = {
+    8000, 11025, 16000, 22050, 24000, 32000, 44100, 48000
+};
+
+constexpr double PI = 3.14159265358979323846;
+
+DWORD Gcd(DWORD a, DWORD b)
+{
+    while (b != 0) {
+        DWORD t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+}  // namespace
+
+bool Resampler::CanHandle(const WAVEFORMATEX* wfx)
+{
+    if (!wfx || wfx->wFormatTag != WAVE_FORMAT_PCM ||
+        wfx->wBitsPerSample != 16 || wfx->nChannels != 1) {
+        return false;
+    }
+    for (DWORD rate : SUPPORTED_RATES) {
+        if (wfx->nSamplesPerSec == rate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Resampler::DetectAvx2()
+{
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // AVX needs OS support for YMM state (OSXSAVE + XCR0 bits 1-2)
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;  // EBX bit 5 = AVX2
+}
+
+void Resampler::Configure(DWORD inRate, DWORD outRate)
+{
+    if (inRate == outRate || inRate == 0 || outRate == 0) {
+        m_active = false;
+        return;
+    }
+
+    DWORD g = Gcd(inRate, outRate);
+    m_L = static_cast<int>(outRate / g);
+    m_M = static_cast<int>(inRate / g);
+    m_useAvx2 = DetectAvx2();
+
+    // Windowed-sinc prototype lowpass, designed at the upsampled rate
+    // (inRate * L). Cut off just under the narrower Nyquist so both
+    // imaging (upsample) and aliasing (downsample) are suppressed.
+    const int total = m_L * TAPS;
+    const double center = (total - 1) / 2.0;
+    const double fc = 0.45 * min(inRate, outRate) /
+                      (static_cast<double>(inRate) * m_L);
+
+    std::vector<double> proto(total);
+    for (int i = 0; i < total; ++i) {
+        double x = i - center;
+        double sinc = (x == 0.0) ? 2.0 * fc
+                                 : sin(2.0 * PI * fc * x) / (PI * x);
+        double window = 0.54 - 0.46 * cos(2.0 * PI * i / (total - 1));
+        proto[i] = sinc * window * m_L;  // Gain L restores unity passband
+    }
+
+    // Scatter the prototype into per-phase rows, reversed so each output
+    // sample is a straight dot product against TAPS consecutive inputs
+    m_coef.assign(static_cast<size_t>(m_L) * TAPS, 0.0f);
+    for (int p = 0; p < m_L; ++p) {
+        for (int j = 0; j < TAPS; ++j) {
+            m_coef[static_cast<size_t>(p) * TAPS + (TAPS - 1 - j)] =
+                static_cast<float>(proto[p + j * m_L]);
+        }
+    }
+
+    m_active = true;
+    Reset();
+}
+
+void Resampler::Reset()
+{
+    // Zero history primes the filter; the clock starts at the first input
+    // index with a full window behind it
+    m_input.assign(TAPS - 1, 0.0f);
+    m_t = static_cast<ULONGLONG>(TAPS - 1) * m_L;
+}
+
+float Resampler::Dot(const float* coef, const float* x) const
+{
+    static_assert(TAPS == 16, "Dot kernels are written for 16 taps");
+    if (m_useAvx2) {
+        __m256 acc = _mm256_mul_ps(_mm256_loadu_ps(coef), _mm256_loadu_ps(x));
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(coef + 8),
+                                               _mm256_loadu_ps(x + 8)));
+        __m128 sum = _mm_add_ps(_mm256_castps256_ps128(acc),
+                                _mm256_extractf128_ps(acc, 1));
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1));
+        return _mm_cvtss_f32(sum);
+    }
+
+    __m128 acc = _mm_mul_ps(_mm_loadu_ps(coef), _mm_loadu_ps(x));
+    for (int j = 4; j < TAPS; j += 4) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(coef + j),
+                                         _mm_loadu_ps(x + j)));
+    }
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+    return _mm_cvtss_f32(acc);
+}
+
+const BYTE* Resampler::Process(const BYTE* data, DWORD size, DWORD& outSize)
+{
+    if (!m_active) {
+        outSize = size;
+        return data;
+    }
+
+    // Append the chunk (as float) after the carried history
+    const short* samples = reinterpret_cast<const short*>(data);
+    const size_t count = size / sizeof(short);
+    const size_t base = m_input.size();
+    m_input.resize(base + count);
+    for (size_t i = 0; i < count; ++i) {
+        m_input[base + i] = static_cast<float>(samples[i]);
+    }
+
+    const size_t avail = m_input.size();
+    m_output.clear();
+    m_output.reserve((count * m_L / m_M + 1) * sizeof(short));
+
+    // Emit every output sample whose filter window is fully available
+    while (m_t / m_L < avail) {
+        const size_t inPos = static_cast<size_t>(m_t / m_L);
+        const size_t phase = static_cast<size_t>(m_t % m_L);
+        float acc = Dot(&m_coef[phase * TAPS], &m_input[inPos - (TAPS - 1)]);
+
+        int v = static_cast<int>(acc + (acc >= 0.0f ? 0.5f : -0.5f));
+        if (v > 32767) v = 32767;
+        if (v < -32768) v = -32768;
+        short out = static_cast<short>(v);
+        const BYTE* p = reinterpret_cast<const BYTE*>(&out);
+        m_output.insert(m_output.end(), p, p + sizeof(short));
+        m_t += m_M;
+    }
+
+    // Keep only the TAPS-1 newest samples as history and rebase the clock
+    const size_t consumed = avail - (TAPS - 1);
+    m_input.erase(m_input.begin(), m_input.begin() + consumed);
+    m_t -= static_cast<ULONGLONG>(consumed) * m_L;
+
+    outSize = static_cast<DWORD>(m_output.size());
+    return m_output.data();
+}
@@ -0,0 +1,71 @@
+// Resampler.h
+// SIMD polyphase resampler for native output-format negotiation
+//
+// The model always produces 24kHz/16-bit/mono PCM, but many SAPI hosts ask
+// for 22.05kHz or 44.1kHz. If GetOutputFormat insists on 24kHz, SAPI inserts
+// its generic format converter into the path - an extra resample and copy
+// per chunk outside our control. Instead the engine accepts common target
+// rates natively and converts once, vectorized, on the way into
+// ISpTTSEngineSite::Write.
+
+#pragma once
+
+#include <windows.h>
+#include <mmreg.h>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// Resampler - Streaming rational-ratio sample rate converter (16-bit mono)
+//
+// Classic polyphase design: conceptually upsample by L, lowpass, decimate by
+// M, where L/M is the reduced ratio of target to source rate. Each output
+// sample is one TAPS-wide dot product against the phase's coefficient row,
+// computed with AVX2 when the CPU has it and SSE2 (x64 baseline) otherwise.
+// State carries across chunks, so feeding the utterance chunk by chunk
+// produces the same samples as converting it whole.
+//-----------------------------------------------------------------------------
+class Resampler
+{
+public:
+    // True if wfx is a PCM format this resampler can produce natively
+    // (16-bit mono at a supported rate)
+    static bool CanHandle(const WAVEFORMATEX* wfx);
+
+    // Set the conversion ratio and reset state. Equal rates deactivate the
+    // resampler (Process then passes chunks through untouched).
+    void Configure(DWORD inRate, DWORD outRate);
+
+    bool Active() const { return m_active; }
+
+    // Output samples produced per input sample (1.0 when inactive)
+    double Ratio() const
+    {
+        return m_active ? static_cast<double>(m_L) / m_M : 1.0;
+    }
+
+    // Drop carried state at an utterance boundary
+    void Reset();
+
+    // Convert one chunk of 16-bit mono PCM. Returns a pointer into an
+    // internal buffer, valid until the next Process call; outSize may be 0
+    // when the chunk is too small to produce a full output sample.
+    const BYTE* Process(const BYTE* data, DWORD size, DWORD& outSize);
+
+private:
+    // Taps per phase. 16 floats = two AVX2 registers; the filter spans
+    // two-thirds of a millisecond of 24kHz input, well under a chunk.
+    static constexpr int TAPS = 16;
+
+    static bool DetectAvx2();
+
+    float Dot(const float* coef, const float* x) const;
+
+    bool m_active = false;
+    bool m_useAvx2 = false;
+    int m_L = 1;                    // Interpolation factor
+    int m_M = 1;                    // Decimation factor
+    std::vector<float> m_coef;      // L phases x TAPS, phase-major, reversed
+    std::vector<float> m_input;     // History (TAPS-1 samples) + current chunk
+    std::vector<BYTE> m_output;     // Converted PCM handed back to the caller
+    ULONGLONG m_t = 0;              // Output clock in 1/L input-sample units
+};
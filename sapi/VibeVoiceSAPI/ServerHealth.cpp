@@ -0,0 +1,66 @@
+// ServerHealth.cpp
+// Process-wide server-liveness cache with exponential backoff
+
+#include "VibeVoiceSAPI.h"
+#include "ServerHealth.h"
+
+//=============================================================================
+// ServerHealth Implementation
+//=============================================================================
+
+ServerHealth& ServerHealth::Instance()
+{
+    // Constructed on first use, destroyed at DLL unload
+    static ServerHealth s_instance;
+    return s_instance;
+}
+
+bool ServerHealth::ShouldAttempt(const wchar_t* probePipeName)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_serverUp) {
+        return true;
+    }
+
+    if (GetTickCount64() < m_nextProbeTick) {
+        return false;  // Still inside the backoff window
+    }
+
+    // No pipe to probe (TCP transport): admit one real attempt per window
+    // and let its verdict re-arm or clear the gate
+    if (!probePipeName) {
+        m_nextProbeTick = GetTickCount64() + m_backoffMs;
+        return true;
+    }
+
+    // Existence probe: with a zero-ish timeout WaitNamedPipeW returns
+    // immediately - ERROR_FILE_NOT_FOUND when no server has created the
+    // pipe, success when an instance is connectable. Either way it never
+    // blocks the Speak thread.
+    if (!WaitNamedPipeW(probePipeName, 1)) {
+        if (m_backoffMs < MAX_BACKOFF_MS) {
+            m_backoffMs *= 2;
+        }
+        m_nextProbeTick = GetTickCount64() + m_backoffMs;
+        return false;
+    }
+
+    // The pipe is back - let one real connect through to confirm. The
+    // verdict (ReportSuccess/ReportFailure) resets or re-arms the gate.
+    return true;
+}
+
+void ServerHealth::ReportSuccess()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_serverUp = true;
+    m_backoffMs = MIN_BACKOFF_MS;
+}
+
+void ServerHealth::ReportFailure()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_serverUp = false;
+    m_nextProbeTick = GetTickCount64() + m_backoffMs;
+}
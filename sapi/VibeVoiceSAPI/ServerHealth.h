@@ -0,0 +1,52 @@
+// ServerHealth.h
+// Process-wide server-liveness cache with exponential backoff
+//
+// When the Python server is down, letting every Speak call walk into
+// WaitNamedPipeW's 30-second timeout freezes the host's speech queue for
+// half a minute per utterance. All engine instances instead share one
+// liveness verdict: once a connect fails, subsequent attempts fast-fail
+// for a backoff window, and only a cheap non-blocking existence probe -
+// microseconds, not seconds - can reopen the gate.
+
+#pragma once
+
+#include <windows.h>
+#include <mutex>
+
+//-----------------------------------------------------------------------------
+// ServerHealth - Singleton gate in front of pipe connect attempts
+//-----------------------------------------------------------------------------
+class ServerHealth
+{
+public:
+    // Process-wide instance (lives until DLL unload)
+    static ServerHealth& Instance();
+
+    // Gate a connect attempt. While the server is believed up this is a
+    // single mutex-protected flag test. While it is believed down, the call
+    // returns false (caller should fail fast) until the backoff window
+    // expires; then one cheap existence probe against probePipeName decides
+    // whether to let a real connect through or extend the backoff. A null
+    // probePipeName (TCP transport - nothing to probe without blocking)
+    // skips the probe and lets one attempt through per window instead.
+    bool ShouldAttempt(const wchar_t* probePipeName);
+
+    // Verdicts from actual connect attempts
+    void ReportSuccess();
+    void ReportFailure();
+
+private:
+    ServerHealth() = default;
+    ~ServerHealth() = default;
+
+    // Backoff doubles from half a second up to half a minute, so a dead
+    // backend costs at most one probe per window instead of a timeout per
+    // utterance, and recovery is noticed within seconds
+    static constexpr DWORD MIN_BACKOFF_MS = 500;
+    static constexpr DWORD MAX_BACKOFF_MS = 30000;
+
+    std::mutex m_mutex;
+    bool m_serverUp = true;         // Optimistic until proven otherwise
+    DWORD m_backoffMs = MIN_BACKOFF_MS;
+    ULONGLONG m_nextProbeTick = 0;  // GetTickCount64 deadline for the probe
+};
@@ -0,0 +1,325 @@
+// TextNormalizer.cpp
+// Client-side text normalization ahead of the pipe request
+
+#include "TextNormalizer.h"
+
+#include <climits>
+#include <cwctype>
+
+namespace {
+
+// Compile-time lookup tables. Kept small and boringly common: anything the
+// model speaks acceptably as-is stays out of here.
+
+const wchar_t* const s_ones[] = {
+    L"zero", L"one", L"two", L"three", L"four", L"five", L"six", L"seven",
+    L"eight", L"nine", L"ten", L"eleven", L"twelve", L"thirteen",
+    L"fourteen", L"fifteen", L"sixteen", L"seventeen", L"eighteen",
+    L"nineteen"
+};
+
+const wchar_t* const s_tens[] = {
+    L"", L"", L"twenty", L"thirty", L"forty", L"fifty", L"sixty",
+    L"seventy", L"eighty", L"ninety"
+};
+
+struct Scale {
+    unsigned long long value;
+    const wchar_t* name;
+};
+constexpr Scale s_scales[] = {
+    { 1000000000000ULL, L"trillion" },
+    { 1000000000ULL, L"billion" },
+    { 1000000ULL, L"million" },
+    { 1000ULL, L"thousand" },
+};
+
+// Abbreviations expanded only at token boundaries; the trailing period is
+// part of the match so "Dr." expands but "Drive" never does
+struct Abbreviation {
+    const wchar_t* abbr;
+    const wchar_t* expansion;
+};
+constexpr Abbreviation s_abbreviations[] = {
+    { L"Dr.", L"Doctor" },
+    { L"Mr.", L"Mister" },
+    { L"Mrs.", L"Missus" },
+    { L"Ms.", L"Miss" },
+    { L"Prof.", L"Professor" },
+    { L"St.", L"Saint" },
+    { L"Jr.", L"Junior" },
+    { L"Sr.", L"Senior" },
+    { L"Ave.", L"Avenue" },
+    { L"Blvd.", L"Boulevard" },
+    { L"Rd.", L"Road" },
+    { L"Mt.", L"Mount" },
+    { L"approx.", L"approximately" },
+    { L"etc.", L"et cetera" },
+    { L"vs.", L"versus" },
+    { L"e.g.", L"for example" },
+    { L"i.e.", L"that is" },
+};
+
+// Symbols with an obvious spoken form; everything else uncommon is stripped
+struct SymbolWord {
+    wchar_t symbol;
+    const wchar_t* spoken;
+};
+constexpr SymbolWord s_symbols[] = {
+    { L'&', L" and " },
+    { L'%', L" percent " },
+    { L'+', L" plus " },
+    { L'=', L" equals " },
+    { L'@', L" at " },
+    { L'#', L" number " },
+    { L'/', L" slash " },
+};
+
+// Punctuation the model handles natively and should keep
+bool IsSpeakablePunct(wchar_t ch)
+{
+    return ch == L'.' || ch == L',' || ch == L'!' || ch == L'?' ||
+           ch == L';' || ch == L':' || ch == L'\'' || ch == L'"' ||
+           ch == L'(' || ch == L')' || ch == L'-';
+}
+
+bool IsTokenBoundary(const std::wstring& text, size_t pos)
+{
+    return pos == 0 || iswspace(text[pos - 1]) || text[pos - 1] == L'(';
+}
+
+}  // namespace
+
+//=============================================================================
+// TextNormalizer Implementation
+//=============================================================================
+
+void TextNormalizer::Append(std::wstring& out, std::vector<size_t>* map,
+                            const std::wstring& s, size_t src)
+{
+    for (wchar_t ch : s) {
+        if (iswspace(ch)) {
+            // Collapse whitespace runs as they are produced, so expansions
+            // that pad themselves with spaces never stack blanks
+            if (out.empty() || out.back() == L' ') {
+                continue;
+            }
+            ch = L' ';
+        }
+        out.push_back(ch);
+        if (map) {
+            map->push_back(src);
+        }
+    }
+}
+
+std::wstring TextNormalizer::NumberToWords(unsigned long long value)
+{
+    if (value < 20) {
+        return s_ones[value];
+    }
+    if (value < 100) {
+        std::wstring words = s_tens[value / 10];
+        if (value % 10) {
+            words += L"-";
+            words += s_ones[value % 10];
+        }
+        return words;
+    }
+    if (value < 1000) {
+        std::wstring words = s_ones[value / 100];
+        words += L" hundred";
+        if (value % 100) {
+            words += L" ";
+            words += NumberToWords(value % 100);
+        }
+        return words;
+    }
+    for (const Scale& scale : s_scales) {
+        if (value >= scale.value) {
+            std::wstring words = NumberToWords(value / scale.value);
+            words += L" ";
+            words += scale.name;
+            if (value % scale.value) {
+                words += L" ";
+                words += NumberToWords(value % scale.value);
+            }
+            return words;
+        }
+    }
+    return s_ones[0];  // Unreachable: scales cover everything >= 1000
+}
+
+std::wstring TextNormalizer::ReadNumber(const std::wstring& text, size_t& pos)
+{
+    // Integer part; overflow past the scale table degrades to digit-by-digit
+    unsigned long long value = 0;
+    bool overflow = false;
+    size_t start = pos;
+    while (pos < text.size() && iswdigit(text[pos])) {
+        if (value > (ULLONG_MAX - 9) / 10) {
+            overflow = true;
+        }
+        value = value * 10 + (text[pos] - L'0');
+        ++pos;
+    }
+
+    std::wstring words;
+    if (overflow || pos - start > 15) {
+        for (size_t i = start; i < pos; ++i) {
+            if (!words.empty()) {
+                words += L" ";
+            }
+            words += s_ones[text[i] - L'0'];
+        }
+    }
+    else {
+        words = NumberToWords(value);
+    }
+
+    // Decimal part is read digit by digit: "3.14" -> "three point one four"
+    if (pos + 1 < text.size() && text[pos] == L'.' && iswdigit(text[pos + 1])) {
+        ++pos;
+        words += L" point";
+        while (pos < text.size() && iswdigit(text[pos])) {
+            words += L" ";
+            words += s_ones[text[pos] - L'0'];
+            ++pos;
+        }
+    }
+    return words;
+}
+
+std::wstring TextNormalizer::Normalize(const std::wstring& text,
+                                       std::vector<size_t>* srcMap)
+{
+    std::wstring out;
+    out.reserve(text.size());
+    if (srcMap) {
+        srcMap->clear();
+        srcMap->reserve(text.size());
+    }
+
+    size_t i = 0;
+    while (i < text.size()) {
+        wchar_t ch = text[i];
+
+        // Typographic variants the server used to fold
+        if (ch == L'‘' || ch == L'’') {
+            Append(out, srcMap, L"'", i++);
+            continue;
+        }
+        if (ch == L'“' || ch == L'”') {
+            Append(out, srcMap, L"\"", i++);
+            continue;
+        }
+        if (ch == L'–' || ch == L'—') {
+            Append(out, srcMap, L"-", i++);
+            continue;
+        }
+        if (ch == L'…') {
+            Append(out, srcMap, L"...", i++);
+            continue;
+        }
+
+        // "$12.50" reads amount-first; a lone '$' is just stripped
+        if (ch == L'$' && i + 1 < text.size() && iswdigit(text[i + 1])) {
+            size_t start = i++;
+            Append(out, srcMap, L" ", start);
+            Append(out, srcMap, ReadNumber(text, i), start);
+            Append(out, srcMap, L" dollars ", start);
+            continue;
+        }
+
+        if (iswdigit(ch)) {
+            size_t start = i;
+            Append(out, srcMap, L" ", start);
+            Append(out, srcMap, ReadNumber(text, i), start);
+            Append(out, srcMap, L" ", start);
+            continue;
+        }
+
+        // Abbreviations, matched at token starts only
+        if (iswalpha(ch) && IsTokenBoundary(text, i)) {
+            bool expanded = false;
+            for (const Abbreviation& entry : s_abbreviations) {
+                size_t len = wcslen(entry.abbr);
+                if (text.compare(i, len, entry.abbr) == 0 &&
+                    (i + len == text.size() || iswspace(text[i + len]))) {
+                    Append(out, srcMap, entry.expansion, i);
+                    i += len;
+                    expanded = true;
+                    break;
+                }
+            }
+            if (expanded) {
+                continue;
+            }
+        }
+
+        bool spoken = false;
+        for (const SymbolWord& entry : s_symbols) {
+            if (ch == entry.symbol) {
+                Append(out, srcMap, entry.spoken, i++);
+                spoken = true;
+                break;
+            }
+        }
+        if (spoken) {
+            continue;
+        }
+
+        if (iswalpha(ch) || iswspace(ch) || IsSpeakablePunct(ch)) {
+            // Expansions pad themselves with a trailing space; sentence
+            // punctuation right after one reattaches ("123." -> "... three.")
+            if (wcschr(L".,!?;:", ch) && !out.empty() && out.back() == L' ') {
+                out.pop_back();
+                if (srcMap) {
+                    srcMap->pop_back();
+                }
+            }
+            Append(out, srcMap, std::wstring(1, ch), i);
+        }
+        // Everything else (emoji, math symbols, control characters) is the
+        // documented unstable territory - stripped
+        ++i;
+    }
+
+    // Trim; map entries track one-to-one, so they trim with the text
+    while (!out.empty() && out.back() == L' ') {
+        out.pop_back();
+        if (srcMap) {
+            srcMap->pop_back();
+        }
+    }
+
+    if (out.empty()) {
+        return out;
+    }
+    size_t tail = text.empty() ? 0 : text.size() - 1;
+
+    // Very short inputs destabilize the model; a trailing ellipsis pads the
+    // context and synthesizes as a brief pause rather than extra words
+    size_t wordCount = 0;
+    bool inWord = false;
+    for (wchar_t c : out) {
+        if (iswspace(c)) {
+            inWord = false;
+        }
+        else if (!inWord) {
+            inWord = true;
+            ++wordCount;
+        }
+    }
+    if (wordCount < 3) {
+        Append(out, srcMap, L" ...", tail);
+    }
+
+    // Mirror the server: end on punctuation so the EOS classifier has a
+    // clean boundary to latch onto
+    if (wcschr(L".!?,:;", out.back()) == nullptr) {
+        Append(out, srcMap, L".", tail);
+    }
+
+    return out;
+}
@@ -0,0 +1,46 @@
+// TextNormalizer.h
+// Client-side text normalization ahead of the pipe request
+//
+// The model docs list numbers, uncommon symbols and very short inputs as
+// destabilizing, yet raw fragment text used to go straight onto the wire -
+// the Python server normalized under the GIL per request, and inputs that
+// were going to fail still paid a full connect/synthesis cycle before the
+// error came back. Cleaning the text in the DLL means the server receives
+// speakable words, cache keys are computed on the same canonical form every
+// host produces, and doomed requests never reach the GPU.
+
+#pragma once
+
+#include <windows.h>
+#include <string>
+#include <vector>
+
+//-----------------------------------------------------------------------------
+// TextNormalizer - Digits to words, abbreviations, symbols, short inputs
+//-----------------------------------------------------------------------------
+class TextNormalizer
+{
+public:
+    // Produce the canonical speakable form of 'text'. If srcMap is non-null
+    // it is filled with one entry per output character: the index in 'text'
+    // of the character it derives from (expansions map every generated
+    // character to the start of the token they replaced). The map is what
+    // lets word-boundary events keep pointing into the host's original
+    // input after lengths shift.
+    static std::wstring Normalize(const std::wstring& text,
+                                  std::vector<size_t>* srcMap = nullptr);
+
+private:
+    // Spell out a non-negative integer ("one hundred twenty-three");
+    // values beyond the scale table fall back to digit-by-digit
+    static std::wstring NumberToWords(unsigned long long value);
+
+    // Digit run (with optional decimal part) starting at 'pos'; returns the
+    // spoken form and advances 'pos' past the consumed characters
+    static std::wstring ReadNumber(const std::wstring& text, size_t& pos);
+
+    // Append 's' to 'out', recording 'src' for every appended character and
+    // collapsing runs of whitespace as they are produced
+    static void Append(std::wstring& out, std::vector<size_t>* map,
+                       const std::wstring& s, size_t src);
+};
@@ -0,0 +1,184 @@
+// TokenCache.cpp
+// Process-wide cache of voice token attributes
+
+#include "VibeVoiceSAPI.h"
+#include "TokenCache.h"
+
+namespace {
+
+// Voice tokens live under these keys (machine-wide installs and per-user
+// overrides); a change anywhere below either one invalidates the cache
+constexpr wchar_t VOICES_KEY[] = L"SOFTWARE\\Microsoft\\Speech\\Voices";
+
+}  // namespace
+
+//=============================================================================
+// TokenCache Implementation
+//=============================================================================
+
+TokenCache& TokenCache::Instance()
+{
+    // Constructed on first use, destroyed at DLL unload
+    static TokenCache s_instance;
+    return s_instance;
+}
+
+void TokenCache::Get(ISpObjectToken* pToken, Attributes& attrs)
+{
+    attrs = Attributes();
+
+    // The token ID is the registry path of the token - unique and stable,
+    // which is exactly what a cache key wants
+    LPWSTR pszId = nullptr;
+    if (FAILED(pToken->GetId(&pszId)) || !pszId) {
+        // No ID to key on (transient in-memory token): read through
+        ReadFromToken(pToken, attrs);
+        return;
+    }
+    std::wstring id(pszId);
+    CoTaskMemFree(pszId);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        EnsureWatcher();
+        auto it = m_cache.find(id);
+        if (it != m_cache.end()) {
+            attrs = it->second;
+            return;
+        }
+    }
+
+    // Miss: read outside the lock (registry I/O), then publish. A racing
+    // reader of the same token does the same read and stores the same
+    // result, which is harmless.
+    ReadFromToken(pToken, attrs);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache[id] = attrs;
+    }
+}
+
+void TokenCache::ReadFromToken(ISpObjectToken* pToken, Attributes& attrs)
+{
+    // Voice ID, converted to ASCII for the pipe protocol
+    CSpDynamicString dstrVoiceId;
+    if (SUCCEEDED(pToken->GetStringValue(L"VoiceId", &dstrVoiceId)) && dstrVoiceId) {
+        int len = WideCharToMultiByte(CP_ACP, 0, dstrVoiceId, -1, NULL, 0, NULL, NULL);
+        if (len > 0) {
+            attrs.voiceId.resize(len);
+            WideCharToMultiByte(CP_ACP, 0, dstrVoiceId, -1, &attrs.voiceId[0],
+                                len, NULL, NULL);
+            if (!attrs.voiceId.empty() && attrs.voiceId.back() == '\0') {
+                attrs.voiceId.pop_back();
+            }
+        }
+    }
+
+    // Optional scheduling priority ("High"/"Low"; anything else is normal)
+    CSpDynamicString dstrPriority;
+    if (SUCCEEDED(pToken->GetStringValue(L"Priority", &dstrPriority)) && dstrPriority) {
+        if (_wcsicmp(dstrPriority, L"High") == 0) {
+            attrs.priorityFlags = FLAG_PRIORITY_HIGH;
+        }
+        else if (_wcsicmp(dstrPriority, L"Low") == 0) {
+            attrs.priorityFlags = FLAG_PRIORITY_LOW;
+        }
+    }
+
+    // Optional offline speak-to-file marker
+    CSpDynamicString dstrBulk;
+    if (SUCCEEDED(pToken->GetStringValue(L"Bulk", &dstrBulk)) && dstrBulk) {
+        attrs.bulkMode = _wcsicmp(dstrBulk, L"0") != 0 &&
+                         _wcsicmp(dstrBulk, L"false") != 0;
+    }
+
+    // Optional non-default server endpoint
+    CSpDynamicString dstrEndpoint;
+    if (SUCCEEDED(pToken->GetStringValue(L"Endpoint", &dstrEndpoint)) && dstrEndpoint) {
+        attrs.endpoint = dstrEndpoint;
+    }
+}
+
+void TokenCache::EnsureWatcher()
+{
+    // Callers hold m_mutex
+    if (m_watcherStarted) {
+        return;
+    }
+
+    // Watch both hives; a key that can't be opened (rare) just isn't
+    // watched, and the cache degrades to never-invalidated for it
+    HKEY hMachine = nullptr;
+    HKEY hUser = nullptr;
+    if (RegOpenKeyExW(HKEY_LOCAL_MACHINE, VOICES_KEY, 0, KEY_NOTIFY,
+                      &hMachine) != ERROR_SUCCESS) {
+        hMachine = nullptr;
+    }
+    if (RegOpenKeyExW(HKEY_CURRENT_USER, VOICES_KEY, 0, KEY_NOTIFY,
+                      &hUser) != ERROR_SUCCESS) {
+        hUser = nullptr;
+    }
+    if (!hMachine && !hUser) {
+        m_watcherStarted = true;    // Nothing to watch; don't retry per Get
+        return;
+    }
+
+    // The watcher loops for the life of the process, so the module
+    // reference SpawnModuleThread takes on its behalf is never released -
+    // effectively pinning the DLL. That is deliberate: the loop executes
+    // DLL code, and letting CoFreeUnusedLibraries unmap it underneath the
+    // thread would be far worse than keeping ~100 KB of code resident.
+    if (!SpawnModuleThread([this, hMachine, hUser]() {
+            WatchLoop(hMachine, hUser);
+        })) {
+        // No watcher: close the keys and degrade to never-invalidated
+        if (hMachine) RegCloseKey(hMachine);
+        if (hUser) RegCloseKey(hUser);
+    }
+    m_watcherStarted = true;
+}
+
+void TokenCache::WatchLoop(HKEY hMachine, HKEY hUser)
+{
+    HANDLE events[2] = {};
+    DWORD count = 0;
+    HKEY keys[2] = {};
+
+    if (hMachine) {
+        events[count] = CreateEventW(NULL, FALSE, FALSE, NULL);
+        keys[count] = hMachine;
+        ++count;
+    }
+    if (hUser) {
+        events[count] = CreateEventW(NULL, FALSE, FALSE, NULL);
+        keys[count] = hUser;
+        ++count;
+    }
+
+    for (;;) {
+        // Arm (or re-arm) a notification per watched key. Subtree watch
+        // covers attribute edits on any individual token.
+        for (DWORD i = 0; i < count; ++i) {
+            RegNotifyChangeKeyValue(keys[i], TRUE,
+                                    REG_NOTIFY_CHANGE_NAME |
+                                    REG_NOTIFY_CHANGE_LAST_SET,
+                                    events[i], TRUE);
+        }
+
+        DWORD wait = WaitForMultipleObjects(count, events, FALSE, INFINITE);
+        if (wait == WAIT_FAILED) {
+            break;
+        }
+
+        // Something under a voices key changed: drop everything. Token
+        // edits are rare (installs, config changes), so the simplicity of
+        // a full flush beats tracking which token the change touched.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cache.clear();
+    }
+
+    for (DWORD i = 0; i < count; ++i) {
+        CloseHandle(events[i]);
+        RegCloseKey(keys[i]);
+    }
+}
@@ -0,0 +1,66 @@
+// TokenCache.h
+// Process-wide cache of voice token attributes
+//
+// Every engine instantiation lands in SetObjectToken, which reads the
+// token's attributes - VoiceId, Priority, Bulk, Endpoint - out of the
+// registry, and hosts that enumerate voices (the Settings speech page, a
+// screen reader's voice dialog) create and destroy dozens of engine
+// instances in a burst. Each attribute is a registry round trip plus a
+// string conversion, so the burst pays the same I/O over and over for
+// values that never change between reads.
+//
+// This cache reads a token's attributes once, keyed by the token ID, and
+// serves every later instantiation from memory. A registry change
+// notification on the voice token keys invalidates the whole cache, so
+// an installer editing a token (or a user changing the Endpoint) is
+// picked up by the next engine instance without a process restart.
+
+#pragma once
+
+#include <windows.h>
+#include <sapi.h>
+#include <map>
+#include <mutex>
+#include <string>
+
+//-----------------------------------------------------------------------------
+// TokenCache - Singleton token-attribute cache with registry invalidation
+//-----------------------------------------------------------------------------
+class TokenCache
+{
+public:
+    // Everything SetObjectToken needs, read in one pass
+    struct Attributes
+    {
+        std::string voiceId;        // ASCII voice ID for the pipe protocol
+        DWORD priorityFlags = 0;    // FLAG_PRIORITY_* or 0 (normal)
+        bool bulkMode = false;      // Offline speak-to-file voice
+        std::wstring endpoint;      // Non-default server; empty = unset
+    };
+
+    // Process-wide instance (lives until DLL unload)
+    static TokenCache& Instance();
+
+    // Fetch the attributes for a token, from cache when warm. A miss reads
+    // the registry through the token interface and caches the result under
+    // the token's ID. Always succeeds; attributes the token doesn't define
+    // keep their defaults (matching a direct GetStringValue miss).
+    void Get(ISpObjectToken* pToken, Attributes& attrs);
+
+private:
+    TokenCache() = default;
+    ~TokenCache() = default;
+
+    // Read every attribute straight from the token (registry I/O)
+    static void ReadFromToken(ISpObjectToken* pToken, Attributes& attrs);
+
+    // Start the registry watcher on first use. It arms change
+    // notifications on the machine and user voice-token keys and clears
+    // the cache whenever either fires, then re-arms.
+    void EnsureWatcher();
+    void WatchLoop(HKEY hMachine, HKEY hUser);
+
+    std::mutex m_mutex;
+    std::map<std::wstring, Attributes> m_cache;     // Token ID -> attributes
+    bool m_watcherStarted = false;
+};
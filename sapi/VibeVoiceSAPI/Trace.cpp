@@ -0,0 +1,21 @@
+// Trace.cpp
+// ETW provider for hot-path latency instrumentation
+
+#include "Trace.h"
+
+// Provider: "VibeVoice-SAPI"
+// {9f1c3a52-6d84-4e1b-9b6e-2f0d7c45a8d1}
+TRACELOGGING_DEFINE_PROVIDER(
+    g_hVibeVoiceTrace,
+    "VibeVoice-SAPI",
+    (0x9f1c3a52, 0x6d84, 0x4e1b, 0x9b, 0x6e, 0x2f, 0x0d, 0x7c, 0x45, 0xa8, 0xd1));
+
+void TraceRegister()
+{
+    TraceLoggingRegister(g_hVibeVoiceTrace);
+}
+
+void TraceUnregister()
+{
+    TraceLoggingUnregister(g_hVibeVoiceTrace);
+}
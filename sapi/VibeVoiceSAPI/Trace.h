@@ -0,0 +1,89 @@
+// Trace.h
+// ETW provider for hot-path latency instrumentation
+//
+// Utterance latency hides in half a dozen places - connect, request write,
+// server first-chunk, inter-chunk gaps, site Write stalls - and attaching a
+// debugger to the SAPI host perturbs exactly what we are trying to measure.
+// This provider emits a timestamped event at each pipeline stage so
+// time-to-first-audio and underrun frequency can be broken down in WPA on a
+// production machine. TraceLogging events are self-describing, so no
+// manifest registration step is needed on the target.
+//
+// Cost when no session is listening: TraceLoggingWrite compiles to a single
+// provider-enabled test and a forward branch, so the hot path stays hot.
+//
+// Capture with:
+//   wpr -start GeneralProfile
+//   traceview / xperf against provider "VibeVoice-SAPI"
+//   {9f1c3a52-6d84-4e1b-9b6e-2f0d7c45a8d1}
+
+#pragma once
+
+#include <windows.h>
+#include <TraceLoggingProvider.h>
+
+TRACELOGGING_DECLARE_PROVIDER(g_hVibeVoiceTrace);
+
+// Register/unregister at DLL attach/detach (both are safe to call from
+// DllMain per the TraceLogging contract)
+void TraceRegister();
+void TraceUnregister();
+
+// Stage events. Verbose-level events fire per chunk/write and are for deep
+// dives; information-level events bound each utterance and request.
+
+#define TRACE_SPEAK_START(textChars) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "SpeakStart", \
+        TraceLoggingLevel(TRACE_LEVEL_INFORMATION), \
+        TraceLoggingUInt32((UINT32)(textChars), "textChars"))
+
+#define TRACE_SPEAK_STOP(hr, bytesWritten) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "SpeakStop", \
+        TraceLoggingLevel(TRACE_LEVEL_INFORMATION), \
+        TraceLoggingInt32((INT32)(hr), "hr"), \
+        TraceLoggingUInt64((UINT64)(bytesWritten), "bytesWritten"))
+
+#define TRACE_CONNECT(hr, elapsedMs) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "Connect", \
+        TraceLoggingLevel(TRACE_LEVEL_INFORMATION), \
+        TraceLoggingInt32((INT32)(hr), "hr"), \
+        TraceLoggingUInt32((UINT32)(elapsedMs), "elapsedMs"))
+
+#define TRACE_REQUEST_START(requestId, textChars, flags) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "RequestStart", \
+        TraceLoggingLevel(TRACE_LEVEL_INFORMATION), \
+        TraceLoggingUInt32((requestId), "requestId"), \
+        TraceLoggingUInt32((UINT32)(textChars), "textChars"), \
+        TraceLoggingUInt32((flags), "flags"))
+
+// Time-to-first-audio for one request, measured from the request write
+#define TRACE_FIRST_AUDIO(requestId, elapsedMs) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "FirstAudio", \
+        TraceLoggingLevel(TRACE_LEVEL_INFORMATION), \
+        TraceLoggingUInt32((requestId), "requestId"), \
+        TraceLoggingUInt32((UINT32)(elapsedMs), "elapsedMs"))
+
+#define TRACE_REQUEST_STOP(requestId, hr, chunks, bytes, elapsedMs) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "RequestStop", \
+        TraceLoggingLevel(TRACE_LEVEL_INFORMATION), \
+        TraceLoggingUInt32((requestId), "requestId"), \
+        TraceLoggingInt32((INT32)(hr), "hr"), \
+        TraceLoggingUInt32((chunks), "chunks"), \
+        TraceLoggingUInt64((UINT64)(bytes), "bytes"), \
+        TraceLoggingUInt32((UINT32)(elapsedMs), "elapsedMs"))
+
+// Per-chunk receive: size plus the gap since the previous chunk, which is
+// what an underrun investigation actually graphs
+#define TRACE_CHUNK(requestId, bytes, gapMs) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "Chunk", \
+        TraceLoggingLevel(TRACE_LEVEL_VERBOSE), \
+        TraceLoggingUInt32((requestId), "requestId"), \
+        TraceLoggingUInt32((UINT32)(bytes), "bytes"), \
+        TraceLoggingUInt32((UINT32)(gapMs), "gapMs"))
+
+// One ISpTTSEngineSite::Write call; a stalled audio device shows up here
+#define TRACE_SITE_WRITE(bytes, elapsedMs) \
+    TraceLoggingWrite(g_hVibeVoiceTrace, "SiteWrite", \
+        TraceLoggingLevel(TRACE_LEVEL_VERBOSE), \
+        TraceLoggingUInt32((UINT32)(bytes), "bytes"), \
+        TraceLoggingUInt32((UINT32)(elapsedMs), "elapsedMs"))
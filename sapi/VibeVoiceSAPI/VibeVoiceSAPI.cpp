@@ -2,7 +2,15 @@
 // SAPI5 TTS Engine implementation for VibeVoice
 
 #include "VibeVoiceSAPI.h"
+#include "AudioCache.h"
+#include "ConnectionManager.h"
+#include "ServerHealth.h"
+#include "TextNormalizer.h"
+#include "TokenCache.h"
+#include "Trace.h"
 #include <strsafe.h>
+#include <algorithm>
+#include <thread>
 
 // Instantiate GUIDs - define storage for our custom GUIDs
 // {A1B2C3D4-E5F6-7890-ABCD-EF1234567890}
@@ -19,403 +27,2337 @@ CVibeVoiceSAPIModule _AtlModule;
 // Register the COM object with ATL - required for DllRegisterServer to work
 OBJECT_ENTRY_AUTO(CLSID_VibeVoiceTTSEngine, CVibeVoiceTTSEngine)
 
+//=============================================================================
+// SpawnModuleThread Implementation
+//=============================================================================
+
+namespace {
+
+struct ModuleThreadContext
+{
+    HMODULE hModule;
+    std::function<void()> work;
+};
+
+DWORD WINAPI ModuleThreadProc(LPVOID param)
+{
+    ModuleThreadContext* ctx = static_cast<ModuleThreadContext*>(param);
+    ctx->work();
+
+    // Destroy the closure before the module reference goes away, then
+    // release and exit in one step - returning normally would execute
+    // unmapped code if this reference was the last one
+    HMODULE hModule = ctx->hModule;
+    delete ctx;
+    FreeLibraryAndExitThread(hModule, 0);
+}
+
+}  // namespace
+
+bool SpawnModuleThread(std::function<void()> work)
+{
+    // Reference the module on the worker's behalf. Taking it from an
+    // address inside this image pins the right module even when these
+    // sources are compiled into another binary (the benchmark harness).
+    HMODULE hModule = nullptr;
+    if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS,
+                            reinterpret_cast<LPCWSTR>(&SpawnModuleThread),
+                            &hModule)) {
+        return false;
+    }
+
+    ModuleThreadContext* ctx = new ModuleThreadContext{ hModule, std::move(work) };
+    HANDLE hThread = CreateThread(NULL, 0, ModuleThreadProc, ctx, 0, NULL);
+    if (!hThread) {
+        delete ctx;
+        FreeLibrary(hModule);
+        return false;
+    }
+    CloseHandle(hThread);
+    return true;
+}
+
+//=============================================================================
+// AudioChunkRing Implementation
+//=============================================================================
+
+AudioChunkRing::AudioChunkRing()
+    : m_hDataEvent(CreateEventW(NULL, FALSE, FALSE, NULL))
+    , m_hSpaceEvent(CreateEventW(NULL, FALSE, FALSE, NULL))
+{
+}
+
+AudioChunkRing::~AudioChunkRing()
+{
+    if (m_hDataEvent) CloseHandle(m_hDataEvent);
+    if (m_hSpaceEvent) CloseHandle(m_hSpaceEvent);
+}
+
+AudioChunkRing::Slot* AudioChunkRing::AcquireSlot(volatile bool* cancelFlag)
+{
+    while (true) {
+        size_t write = m_writeIndex.load(std::memory_order_relaxed);
+        size_t read = m_readIndex.load(std::memory_order_acquire);
+
+        if (write - read < SLOT_COUNT) {
+            return &m_slots[write % SLOT_COUNT];
+        }
+
+        // Ring full - wait for the consumer, but stay responsive to abort
+        if (cancelFlag && *cancelFlag) {
+            return nullptr;
+        }
+        WaitForSingleObject(m_hSpaceEvent, 20);
+    }
+}
+
+void AudioChunkRing::Publish(DWORD size)
+{
+    size_t write = m_writeIndex.load(std::memory_order_relaxed);
+    m_slots[write % SLOT_COUNT].size = size;
+    m_writeIndex.store(write + 1, std::memory_order_release);
+    SetEvent(m_hDataEvent);
+}
+
+bool AudioChunkRing::Push(const BYTE* data, DWORD size, volatile bool* cancelFlag)
+{
+    Slot* slot = AcquireSlot(cancelFlag);
+    if (!slot) {
+        return false;
+    }
+    slot->external = nullptr;
+    slot->isEvent = false;
+    if (size > 0) {
+        slot->data.resize(size);
+        memcpy(slot->data.data(), data, size);
+    }
+    Publish(size);
+    return true;
+}
+
+AudioChunkRing::Slot* AudioChunkRing::Pop(DWORD waitMs)
+{
+    size_t read = m_readIndex.load(std::memory_order_relaxed);
+    if (read == m_writeIndex.load(std::memory_order_acquire)) {
+        WaitForSingleObject(m_hDataEvent, waitMs);
+        if (read == m_writeIndex.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+    }
+    return &m_slots[read % SLOT_COUNT];
+}
+
+void AudioChunkRing::Consume()
+{
+    m_readIndex.fetch_add(1, std::memory_order_release);
+    SetEvent(m_hSpaceEvent);
+}
+
+void AudioChunkRing::Reserve(size_t bytesPerSlot)
+{
+    for (Slot& slot : m_slots) {
+        slot.data.reserve(bytesPerSlot);
+    }
+}
+
+void AudioChunkRing::Reset()
+{
+    m_writeIndex.store(0, std::memory_order_relaxed);
+    m_readIndex.store(0, std::memory_order_relaxed);
+    ResetEvent(m_hDataEvent);
+    ResetEvent(m_hSpaceEvent);
+}
+
+
 //=============================================================================
 // PipeClient Implementation
 //=============================================================================
 
+// How often a pending transfer or an empty ring re-checks for cancellation
+constexpr DWORD IO_POLL_INTERVAL_MS = 20;
+
+// How long to wait for a cancelled stream's end-of-stream, or for an opcode
+// reply, before declaring the server dead
+constexpr DWORD REPLY_TIMEOUT_MS = 2000;
+
+std::mutex PipeClient::s_endpointMutex;
+std::wstring PipeClient::s_endpoint;
+
+void PipeClient::SetEndpoint(const std::wstring& endpoint)
+{
+    std::lock_guard<std::mutex> lock(s_endpointMutex);
+    s_endpoint = endpoint;
+}
+
+std::wstring PipeClient::GetEndpoint()
+{
+    std::lock_guard<std::mutex> lock(s_endpointMutex);
+    return s_endpoint.empty() ? PIPE_NAME : s_endpoint;
+}
+
 PipeClient::PipeClient()
     : m_hPipe(INVALID_HANDLE_VALUE)
+    , m_hReadEvent(CreateEventW(NULL, TRUE, FALSE, NULL))
+    , m_hWriteEvent(CreateEventW(NULL, TRUE, FALSE, NULL))
+    , m_hAbortEvent(CreateEventW(NULL, TRUE, FALSE, NULL))
+    , m_hPongEvent(CreateEventW(NULL, FALSE, FALSE, NULL))
+    , m_hShmReplyEvent(CreateEventW(NULL, FALSE, FALSE, NULL))
+    , m_shmReplyStatus(1)
+    , m_stopFlag(false)
+    , m_readerDead(false)
+    , m_hShmMapping(NULL)
+    , m_hShmSpaceEvent(NULL)
+    , m_shmView(nullptr)
+    , m_shmActive(false)
+    , m_shmReadPos(0)
 {
 }
 
 PipeClient::~PipeClient()
 {
     Disconnect();
+    if (m_hReadEvent) CloseHandle(m_hReadEvent);
+    if (m_hWriteEvent) CloseHandle(m_hWriteEvent);
+    if (m_hAbortEvent) CloseHandle(m_hAbortEvent);
+    if (m_hPongEvent) CloseHandle(m_hPongEvent);
+    if (m_hShmReplyEvent) CloseHandle(m_hShmReplyEvent);
+}
+
+void PipeClient::Abort()
+{
+    SetEvent(m_hAbortEvent);
+    if (m_hPipe != INVALID_HANDLE_VALUE) {
+        CancelIoEx(m_hPipe, NULL);
+    }
 }
 
 HRESULT PipeClient::Connect()
 {
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+
+    if (m_hPipe != INVALID_HANDLE_VALUE) {
+        if (!m_readerDead) {
+            return S_OK;  // Already connected
+        }
+        // The reader bailed (server died mid-stream) - clear the carcass
+        // before reconnecting
+        DisconnectLocked();
+    }
+
+    const std::wstring endpoint = GetEndpoint();
+    const bool isTcp = endpoint.compare(0, 6, L"tcp://") == 0;
+
+    // Shared liveness gate: when the server is known down, fail in
+    // microseconds instead of letting WaitNamedPipeW hold the Speak thread
+    // for up to 30 seconds per utterance
+    if (!ServerHealth::Instance().ShouldAttempt(isTcp ? nullptr : endpoint.c_str())) {
+        return SPERR_DEVICE_BUSY;
+    }
+
+    const ULONGLONG connectStart = GetTickCount64();
+
+    if (isTcp) {
+        HRESULT hr = ConnectTcp(endpoint);
+        if (FAILED(hr)) {
+            ServerHealth::Instance().ReportFailure();
+            TRACE_CONNECT(hr, GetTickCount64() - connectStart);
+            return hr;
+        }
+    }
+    else {
+        // Wait for the (local or remote) pipe to be available
+        if (!WaitNamedPipeW(endpoint.c_str(), PIPE_TIMEOUT_MS)) {
+            DWORD err = GetLastError();
+            ServerHealth::Instance().ReportFailure();
+            if (err == ERROR_SEM_TIMEOUT) {
+                TRACE_CONNECT(HRESULT_FROM_WIN32(ERROR_TIMEOUT),
+                              GetTickCount64() - connectStart);
+                return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+            }
+            TRACE_CONNECT(HRESULT_FROM_WIN32(err),
+                          GetTickCount64() - connectStart);
+            return HRESULT_FROM_WIN32(err);
+        }
+
+        // Open the pipe for overlapped I/O so transfers can be cancelled
+        // mid-flight with CancelIoEx
+        m_hPipe = CreateFileW(
+            endpoint.c_str(),
+            GENERIC_READ | GENERIC_WRITE,
+            0,              // No sharing
+            NULL,           // Default security
+            OPEN_EXISTING,
+            FILE_FLAG_OVERLAPPED,
+            NULL            // No template
+        );
+
+        if (m_hPipe == INVALID_HANDLE_VALUE) {
+            DWORD err = GetLastError();
+            ServerHealth::Instance().ReportFailure();
+            TRACE_CONNECT(HRESULT_FROM_WIN32(err),
+                          GetTickCount64() - connectStart);
+            return HRESULT_FROM_WIN32(err);
+        }
+        m_isSocket = false;
+
+        // Set pipe to message mode (optional, we use byte mode)
+        DWORD mode = PIPE_READMODE_BYTE;
+        SetNamedPipeHandleState(m_hPipe, &mode, NULL, NULL);
+    }
+
+    // The demux reader owns every read on this connection for its lifetime;
+    // between requests it simply sits in a blocked read waiting for the next
+    // tagged frame
+    m_stopFlag = false;
+    m_readerDead = false;
+    m_rxBuffer.resize(PIPE_BUFFER_SIZE);
+    m_rxHead = 0;
+    m_rxTail = 0;
+    ResetEvent(m_hAbortEvent);
+    m_readerThread = std::thread(&PipeClient::DemuxLoop, this);
+
+    ServerHealth::Instance().ReportSuccess();
+    TRACE_CONNECT(S_OK, GetTickCount64() - connectStart);
+    PerfCounters::Instance().RecordConnect();
+    return S_OK;
+}
+
+HRESULT PipeClient::ConnectTcp(const std::wstring& endpoint)
+{
+    // One-time Winsock init for the process
+    static std::once_flag s_wsaInit;
+    static int s_wsaResult = -1;
+    std::call_once(s_wsaInit, []() {
+        WSADATA wsaData;
+        s_wsaResult = WSAStartup(MAKEWORD(2, 2), &wsaData);
+    });
+    if (s_wsaResult != 0) {
+        return E_FAIL;
+    }
+
+    // Split "tcp://host:port" (the last colon, so IPv6 literals survive)
+    std::wstring rest = endpoint.substr(6);
+    size_t colon = rest.rfind(L':');
+    if (colon == std::wstring::npos || colon == 0 || colon + 1 >= rest.size()) {
+        return E_INVALIDARG;
+    }
+    std::wstring host = rest.substr(0, colon);
+    std::wstring port = rest.substr(colon + 1);
+
+    ADDRINFOW hints = {};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    ADDRINFOW* result = nullptr;
+    if (GetAddrInfoW(host.c_str(), port.c_str(), &hints, &result) != 0) {
+        return HRESULT_FROM_WIN32(WSAGetLastError());
+    }
+
+    SOCKET sock = INVALID_SOCKET;
+    for (ADDRINFOW* addr = result; addr != nullptr; addr = addr->ai_next) {
+        // Overlapped socket: the handle then supports the same ReadFile/
+        // WriteFile/CancelIoEx paths as a pipe handle, so everything above
+        // Connect() stays transport-agnostic
+        sock = WSASocketW(addr->ai_family, addr->ai_socktype, addr->ai_protocol,
+                          NULL, 0, WSA_FLAG_OVERLAPPED);
+        if (sock == INVALID_SOCKET) {
+            continue;
+        }
+        if (connect(sock, addr->ai_addr, static_cast<int>(addr->ai_addrlen)) == 0) {
+            break;
+        }
+        closesocket(sock);
+        sock = INVALID_SOCKET;
+    }
+    FreeAddrInfoW(result);
+
+    if (sock == INVALID_SOCKET) {
+        return HRESULT_FROM_WIN32(WSAGetLastError());
+    }
+
+    // Audio chunks are small and latency-critical; never let Nagle hold one
+    BOOL noDelay = TRUE;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY,
+               reinterpret_cast<const char*>(&noDelay), sizeof(noDelay));
+
+    m_hPipe = reinterpret_cast<HANDLE>(sock);
+    m_isSocket = true;
+    return S_OK;
+}
+
+void PipeClient::Disconnect()
+{
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    DisconnectLocked();
+}
+
+void PipeClient::DisconnectIfDead()
+{
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+    if (m_readerDead) {
+        DisconnectLocked();
+    }
+}
+
+void PipeClient::DisconnectLocked()
+{
+    if (m_readerThread.joinable()) {
+        m_stopFlag = true;
+        SetEvent(m_hAbortEvent);
+        if (m_hPipe != INVALID_HANDLE_VALUE) {
+            CancelIoEx(m_hPipe, NULL);
+        }
+        m_readerThread.join();
+        m_stopFlag = false;
+        ResetEvent(m_hAbortEvent);
+    }
+    // Consumers draining a failed stream may still hold zero-copy pointers
+    // into the SHM view; give them a bounded window to finish before the
+    // mapping disappears under their feet
+    for (int i = 0; i < 250; ++i) {
+        {
+            std::lock_guard<std::mutex> lock(m_routeMutex);
+            if (m_routes.empty()) {
+                break;
+            }
+        }
+        Sleep(IO_POLL_INTERVAL_MS);
+    }
+    TeardownSharedMemory();
     if (m_hPipe != INVALID_HANDLE_VALUE) {
-        return S_OK;  // Already connected
+        if (m_isSocket) {
+            closesocket(reinterpret_cast<SOCKET>(m_hPipe));
+        } else {
+            CloseHandle(m_hPipe);
+        }
+        m_hPipe = INVALID_HANDLE_VALUE;
+        m_isSocket = false;
+    }
+}
+
+void PipeClient::SetupSharedMemory()
+{
+    std::lock_guard<std::mutex> lock(m_lifecycleMutex);
+
+    if (m_shmActive || m_hPipe == INVALID_HANDLE_VALUE || m_readerDead) {
+        return;
+    }
+
+    // A remote server (remote pipe or TCP) cannot open a file mapping in
+    // this session, so zero-copy is only negotiated over a local pipe
+    if (GetEndpoint().compare(0, 9, L"\\\\.\\pipe\\") != 0) {
+        return;
+    }
+
+    // Unique per negotiation so reconnects never collide with a mapping the
+    // server still has open
+    static std::atomic<DWORD> s_counter{ 0 };
+    wchar_t name[64];
+    swprintf_s(name, L"Local\\VibeVoiceShm_%lu_%lu",
+               GetCurrentProcessId(), s_counter.fetch_add(1) + 1);
+    wchar_t eventName[80];
+    swprintf_s(eventName, L"%s_space", name);
+
+    m_hShmMapping = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                       0, SHM_HEADER_BYTES + SHM_RING_BYTES, name);
+    if (m_hShmMapping) {
+        m_shmView = static_cast<BYTE*>(
+            MapViewOfFile(m_hShmMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0));
+    }
+    if (m_shmView) {
+        m_hShmSpaceEvent = CreateEventW(NULL, FALSE, FALSE, eventName);
+    }
+    if (!m_hShmSpaceEvent) {
+        TeardownSharedMemory();
+        return;
+    }
+
+    memset(m_shmView, 0, SHM_HEADER_BYTES);
+    m_shmReadPos = 0;
+
+    // [4 bytes] opcode
+    // [4 bytes] ring size
+    // [64 bytes] mapping name (ASCII, null-padded); the space event is the
+    //            same name with a "_space" suffix
+    BYTE request[4 + 4 + 64] = { 0 };
+    DWORD opcode = OP_SETUP_SHM;
+    DWORD ringBytes = SHM_RING_BYTES;
+    memcpy(request, &opcode, 4);
+    memcpy(request + 4, &ringBytes, 4);
+    for (size_t i = 0; i < 63 && name[i]; ++i) {
+        request[8 + i] = static_cast<BYTE>(name[i]);
+    }
+
+    // The acknowledgement comes back through the demux reader
+    ResetEvent(m_hShmReplyEvent);
+    m_shmReplyStatus = 1;
+    HRESULT hr;
+    {
+        std::lock_guard<std::mutex> writeLock(m_writeMutex);
+        hr = WriteExact(request, sizeof(request));
+    }
+    if (FAILED(hr) ||
+        WaitForSingleObject(m_hShmReplyEvent, REPLY_TIMEOUT_MS) != WAIT_OBJECT_0 ||
+        m_shmReplyStatus != 0) {
+        TeardownSharedMemory();
+        return;
+    }
+
+    m_shmActive = true;
+}
+
+void PipeClient::TeardownSharedMemory()
+{
+    m_shmActive = false;
+    {
+        std::lock_guard<std::mutex> lock(m_shmQueueMutex);
+        m_shmQueue.clear();
+    }
+    if (m_shmView) {
+        UnmapViewOfFile(m_shmView);
+        m_shmView = nullptr;
     }
+    if (m_hShmMapping) {
+        CloseHandle(m_hShmMapping);
+        m_hShmMapping = NULL;
+    }
+    if (m_hShmSpaceEvent) {
+        CloseHandle(m_hShmSpaceEvent);
+        m_hShmSpaceEvent = NULL;
+    }
+}
+
+const BYTE* PipeClient::ShmChunkPtr(DWORD size, ULONGLONG& endPos)
+{
+    DWORD offset = static_cast<DWORD>(m_shmReadPos % SHM_RING_BYTES);
+    if (SHM_RING_BYTES - offset < size) {
+        // Writer skipped to the ring start to keep the chunk contiguous
+        m_shmReadPos += SHM_RING_BYTES - offset;
+        offset = 0;
+    }
+    m_shmReadPos += size;
+    endPos = m_shmReadPos;
+    return m_shmView + SHM_HEADER_BYTES + offset;
+}
+
+void PipeClient::ShmPublishReadPos(ULONGLONG pos)
+{
+    *reinterpret_cast<volatile ULONGLONG*>(m_shmView + 8) = pos;
+    SetEvent(m_hShmSpaceEvent);
+}
+
+void PipeClient::RegisterShmChunk(ULONGLONG endPos)
+{
+    std::lock_guard<std::mutex> lock(m_shmQueueMutex);
+    m_shmQueue.emplace_back(endPos, false);
+}
+
+void PipeClient::ReleaseShmChunk(ULONGLONG endPos)
+{
+    std::lock_guard<std::mutex> lock(m_shmQueueMutex);
+    for (auto& entry : m_shmQueue) {
+        if (entry.first == endPos) {
+            entry.second = true;
+            break;
+        }
+    }
+    // Ring space frees strictly in arrival order: publish the longest
+    // released prefix, not this chunk's own position - a later chunk must
+    // never release space a slower stream is still reading from
+    ULONGLONG publish = 0;
+    while (!m_shmQueue.empty() && m_shmQueue.front().second) {
+        publish = m_shmQueue.front().first;
+        m_shmQueue.pop_front();
+    }
+    if (publish != 0 && m_shmView) {
+        ShmPublishReadPos(publish);
+    }
+}
+
+HRESULT PipeClient::Transfer(bool isRead, void* buffer, DWORD count)
+{
+    BYTE* ptr = static_cast<BYTE*>(buffer);
+    DWORD remaining = count;
+
+    while (remaining > 0) {
+        DWORD transferred = 0;
+        HRESULT hr = IoOnce(isRead, ptr, remaining, transferred);
+        if (FAILED(hr)) {
+            return hr;
+        }
+        ptr += transferred;
+        remaining -= transferred;
+    }
+
+    return S_OK;
+}
+
+HRESULT PipeClient::IoOnce(bool isRead, void* buffer, DWORD count,
+                           DWORD& transferred)
+{
+    HANDLE hIoEvent = isRead ? m_hReadEvent : m_hWriteEvent;
+    OVERLAPPED ov = { 0 };
+    ResetEvent(hIoEvent);
+    ov.hEvent = hIoEvent;
+
+    transferred = 0;
+    BOOL ok = isRead
+        ? ReadFile(m_hPipe, buffer, count, &transferred, &ov)
+        : WriteFile(m_hPipe, buffer, count, &transferred, &ov);
 
-    // Wait for pipe to be available
-    if (!WaitNamedPipeW(PIPE_NAME, PIPE_TIMEOUT_MS)) {
+    if (!ok) {
         DWORD err = GetLastError();
-        if (err == ERROR_SEM_TIMEOUT) {
-            return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+        if (err != ERROR_IO_PENDING) {
+            return HRESULT_FROM_WIN32(err);
+        }
+
+        // Wait for completion or abort, re-checking the stop flag on a
+        // short interval so a shutdown interrupts a stalled server
+        // within milliseconds rather than after PIPE_TIMEOUT_MS.
+        HANDLE waitHandles[2] = { hIoEvent, m_hAbortEvent };
+        bool cancelled = false;
+        while (true) {
+            DWORD wait = WaitForMultipleObjects(2, waitHandles, FALSE, IO_POLL_INTERVAL_MS);
+            if (wait == WAIT_OBJECT_0) {
+                break;  // I/O complete
+            }
+            if (wait == WAIT_OBJECT_0 + 1 || (isRead && m_stopFlag)) {
+                cancelled = true;
+                break;
+            }
+            if (wait != WAIT_TIMEOUT) {
+                cancelled = true;  // Wait failure - bail out
+                break;
+            }
+        }
+
+        if (cancelled) {
+            CancelIoEx(m_hPipe, &ov);
+        }
+
+        // Always reap the overlapped result so the OVERLAPPED can leave
+        // scope safely, even after a cancel
+        if (!GetOverlappedResult(m_hPipe, &ov, &transferred, TRUE)) {
+            DWORD err2 = GetLastError();
+            return cancelled ? E_ABORT : HRESULT_FROM_WIN32(err2);
+        }
+        if (cancelled) {
+            return E_ABORT;
         }
-        return HRESULT_FROM_WIN32(err);
     }
 
-    // Open the pipe
-    m_hPipe = CreateFileW(
-        PIPE_NAME,
-        GENERIC_READ | GENERIC_WRITE,
-        0,              // No sharing
-        NULL,           // Default security
-        OPEN_EXISTING,
-        0,              // Default attributes
-        NULL            // No template
-    );
+    if (isRead && transferred == 0) {
+        return HRESULT_FROM_WIN32(ERROR_BROKEN_PIPE);
+    }
+    return S_OK;
+}
+
+HRESULT PipeClient::BufferedRead(void* buffer, DWORD count)
+{
+    BYTE* dst = static_cast<BYTE*>(buffer);
+
+    while (count > 0) {
+        if (m_rxHead == m_rxTail) {
+            // Payloads that dwarf the staging buffer (bulk frames) skip the
+            // extra copy and read straight into their destination
+            if (count >= m_rxBuffer.size()) {
+                return Transfer(true, dst, count);
+            }
+            DWORD received = 0;
+            HRESULT hr = IoOnce(true, m_rxBuffer.data(),
+                                static_cast<DWORD>(m_rxBuffer.size()), received);
+            if (FAILED(hr)) {
+                return hr;
+            }
+            m_rxHead = 0;
+            m_rxTail = received;
+        }
+
+        DWORD available = static_cast<DWORD>(m_rxTail - m_rxHead);
+        DWORD n = count < available ? count : available;
+        memcpy(dst, m_rxBuffer.data() + m_rxHead, n);
+        m_rxHead += n;
+        dst += n;
+        count -= n;
+    }
+
+    return S_OK;
+}
 
+HRESULT PipeClient::Ping()
+{
     if (m_hPipe == INVALID_HANDLE_VALUE) {
-        return HRESULT_FROM_WIN32(GetLastError());
+        return HRESULT_FROM_WIN32(ERROR_PIPE_NOT_CONNECTED);
+    }
+
+    // The pong comes back through the demux reader as an [OP_PING][0] frame
+    ResetEvent(m_hPongEvent);
+    DWORD opcode = OP_PING;
+    HRESULT hr;
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        hr = WriteExact(&opcode, 4);
+    }
+    if (SUCCEEDED(hr) &&
+        WaitForSingleObject(m_hPongEvent, REPLY_TIMEOUT_MS) != WAIT_OBJECT_0) {
+        hr = HRESULT_FROM_WIN32(ERROR_TIMEOUT);
     }
 
-    // Set pipe to message mode (optional, we use byte mode)
-    DWORD mode = PIPE_READMODE_BYTE;
-    SetNamedPipeHandleState(m_hPipe, &mode, NULL, NULL);
+    if (FAILED(hr)) {
+        Disconnect();
+    }
+    return hr;
+}
+
+HRESULT PipeClient::PreloadVoice(LPCSTR voiceId)
+{
+    HRESULT hr = Connect();
+    if (FAILED(hr)) {
+        return hr;
+    }
 
-    return S_OK;
+    // [4 bytes] opcode
+    // [32 bytes] voice_id
+    BYTE request[4 + 32] = { 0 };
+    DWORD opcode = OP_PRELOAD_VOICE;
+    memcpy(request, &opcode, 4);
+    if (voiceId) {
+        StringCchCopyA(reinterpret_cast<char*>(request + 4), 32, voiceId);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        hr = WriteExact(request, sizeof(request));
+    }
+    if (FAILED(hr)) {
+        // The connection may be shared with live streams - only tear it
+        // down if the reader actually died
+        DisconnectIfDead();
+    }
+    return hr;
+}
+
+void PipeClient::SendCancel(DWORD requestId)
+{
+    // Best effort: if the write fails the reader is about to fail the route
+    // anyway, which unblocks the caller just the same
+    DWORD message[2] = { OP_CANCEL, requestId };
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    WriteExact(message, sizeof(message));
+}
+
+void PipeClient::SendCredit(DWORD requestId, DWORD count)
+{
+    DWORD message[3] = { OP_CREDIT, requestId, count };
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+    WriteExact(message, sizeof(message));
+}
+
+HRESULT PipeClient::StreamTTS(
+    LPCWSTR text,
+    LPCSTR voiceId,
+    AudioChunkCallback callback,
+    void* callbackContext,
+    volatile bool* cancelFlag,
+    CancelCheckCallback cancelCheck,
+    DWORD requestFlags,
+    WordEventCallback eventCallback)
+{
+    HRESULT hr;
+
+    // The connection is persistent across utterances. A cached handle can be
+    // stale if the server restarted, so validate it with a cheap ping and
+    // fall through to a fresh connect on failure (Ping() disconnects for
+    // us). Skip the ping while other requests are streaming - live traffic
+    // proves the server is up, and a ping timing out under GPU load would
+    // tear their connection down.
+    bool idle;
+    {
+        std::lock_guard<std::mutex> lock(m_routeMutex);
+        idle = m_routes.empty();
+    }
+    if (IsConnected() && idle) {
+        Ping();
+    }
+
+    // Connect if not already connected
+    hr = Connect();
+    if (FAILED(hr)) {
+        return hr;
+    }
+
+    // Best effort: move the audio payload onto the shared-memory ring so
+    // PCM stops being copied through the pipe's kernel buffers
+    SetupSharedMemory();
+
+    // Prepare text as UTF-16LE
+    size_t textLen = wcslen(text);
+    DWORD textBytes = static_cast<DWORD>(textLen * sizeof(wchar_t));
+
+    // Register this request with the demux reader before the server can
+    // answer, then serialize the whole v2 request (header + text) into one
+    // pooled buffer and write it with a single WriteFile
+    StreamState* stream = AcquireStream();
+
+    // Compress the audio over remote transports, where wire bytes (48KB/s
+    // of raw PCM per voice) dominate time-to-first-audio; locally the pipe
+    // is effectively free and the chunks may ride SHM anyway
+    stream->adpcm = GetEndpoint().compare(0, 9, L"\\\\.\\pipe\\") != 0;
+    const DWORD wireFlags = FLAG_FLOW_CONTROL | (m_shmActive ? FLAG_SHM_AUDIO : 0) |
+                            (eventCallback ? FLAG_WORD_EVENTS : 0) |
+                            (stream->adpcm ? FLAG_ADPCM_AUDIO : 0) | requestFlags;
+    {
+        RequestHeaderV2 header = {};
+        header.opcode = OP_REQUEST_V2;
+        header.version = PROTOCOL_VERSION;
+        header.headerBytes = sizeof(RequestHeaderV2);
+        header.textBytes = textBytes;
+        header.flags = wireFlags;
+        if (voiceId) {
+            StringCchCopyA(header.voiceId, sizeof(header.voiceId), voiceId);
+        }
+        header.requestId = stream->requestId;
+
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        m_requestBuffer.resize(sizeof(header) + textBytes);
+        memcpy(m_requestBuffer.data(), &header, sizeof(header));
+        memcpy(m_requestBuffer.data() + sizeof(header), text, textBytes);
+
+        hr = WriteExact(m_requestBuffer.data(), static_cast<DWORD>(m_requestBuffer.size()));
+    }
+    if (FAILED(hr)) {
+        // Don't kill the whole connection here - sibling streams may be
+        // healthy; if the transport really broke, the reader is already
+        // failing and the teardown below handles it
+        ReleaseStream(stream);
+        DisconnectIfDead();
+        return hr;
+    }
+
+    const ULONGLONG requestStart = GetTickCount64();
+    TRACE_REQUEST_START(stream->requestId, (UINT32)textLen, wireFlags);
+    bool firstAudioSeen = false;
+    ULONGLONG firstAudioMs = 0;
+    DWORD traceChunks = 0;
+    ULONGLONG traceBytes = 0;
+    ULONGLONG lastChunkTick = requestStart;
+
+    // Consume this request's ring while the demux reader fills it. Other
+    // requests run their own consumers against the same reader concurrently;
+    // a blocking ISpTTSEngineSite::Write here never stalls them or the pipe.
+    bool consumerCancelled = false;
+    bool cancelSent = false;
+    ULONGLONG cancelDeadline = 0;
+    bool finished = false;
+    DWORD ungranted = 0;
+    while (!finished) {
+        AudioChunkRing::Slot* slot = stream->ring.Pop(IO_POLL_INTERVAL_MS);
+        if (!slot) {
+            // Ring empty - poll the SAPI site from this (the Speak) thread
+            // so an abort is noticed even while the server stalls
+            if (!consumerCancelled &&
+                ((cancelFlag && *cancelFlag) ||
+                 (cancelCheck && cancelCheck(callbackContext)))) {
+                consumerCancelled = true;
+                if (cancelFlag) {
+                    *cancelFlag = true;
+                }
+            }
+            if (consumerCancelled && !cancelSent) {
+                SendCancel(stream->requestId);
+                cancelSent = true;
+                cancelDeadline = GetTickCount64() + REPLY_TIMEOUT_MS;
+            }
+            if (cancelSent && GetTickCount64() > cancelDeadline) {
+                // Server never acknowledged the cancel - kill the
+                // connection; the reader fails this route on its way out
+                Abort();
+                cancelDeadline = MAXULONGLONG;
+            }
+            if (stream->failed) {
+                break;  // Route already failed; nothing more will arrive
+            }
+            continue;
+        }
+
+        if (slot->isEvent) {
+            // Word-boundary metadata queued between its neighboring chunks.
+            // Not an audio chunk: no credit is owed for it.
+            slot->isEvent = false;
+            if (eventCallback && !consumerCancelled) {
+                eventCallback(slot->eventOffset, slot->eventLen, callbackContext);
+            }
+            stream->ring.Consume();
+            continue;
+        }
+
+        if (slot->size == 0) {
+            finished = true;  // End of stream (consume the marker below)
+        }
+        else {
+            const ULONGLONG now = GetTickCount64();
+            if (!firstAudioSeen) {
+                firstAudioSeen = true;
+                firstAudioMs = now - requestStart;
+                TRACE_FIRST_AUDIO(stream->requestId, firstAudioMs);
+            }
+            TRACE_CHUNK(stream->requestId, slot->size, now - lastChunkTick);
+            lastChunkTick = now;
+            traceChunks++;
+            traceBytes += slot->size;
+
+            if (callback && !consumerCancelled) {
+                // SHM chunks hand the callback a pointer straight into the
+                // mapping - a zero-copy path from server to SAPI
+                const BYTE* data = slot->external ? slot->external : slot->data.data();
+                callback(data, slot->size, callbackContext);
+                if (cancelFlag && *cancelFlag) {
+                    consumerCancelled = true;
+                }
+                if (consumerCancelled && !cancelSent) {
+                    SendCancel(stream->requestId);
+                    cancelSent = true;
+                    cancelDeadline = GetTickCount64() + REPLY_TIMEOUT_MS;
+                }
+            }
+        }
+        // Release ring space even for chunks the callback skipped, or a
+        // cancelled stream would wedge the server's ring writer
+        if (slot->external) {
+            ReleaseShmChunk(slot->shmEnd);
+            slot->external = nullptr;
+        }
+        stream->ring.Consume();
+
+        // Each consumed chunk is a credit the server may spend on lookahead.
+        // Grants are batched so the replenish path costs one small write per
+        // CREDIT_BATCH chunks instead of one per chunk. A cancelled stream
+        // stops granting; the server times out and parks the request.
+        if (!finished && !cancelSent && ++ungranted >= CREDIT_BATCH) {
+            SendCredit(stream->requestId, ungranted);
+            ungranted = 0;
+        }
+    }
+
+    hr = consumerCancelled ? E_ABORT : stream->result;
+    TRACE_REQUEST_STOP(stream->requestId, hr, traceChunks, traceBytes,
+                       GetTickCount64() - requestStart);
+    PerfCounters::Instance().RecordRequest(hr, traceBytes, firstAudioMs,
+                                           firstAudioSeen);
+    ReleaseStream(stream);
+
+    // A dead reader means the transport is gone. The last consumer off the
+    // connection tears it down; earlier ones must not, or the SHM view
+    // would vanish while siblings still stream out of it.
+    if (m_readerDead) {
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(m_routeMutex);
+            last = m_routes.empty();
+        }
+        if (last) {
+            DisconnectIfDead();
+        }
+    }
+    return hr;
+}
+
+void PipeClient::DemuxLoop()
+{
+    std::vector<BYTE> discard;
+    HRESULT fatal = S_OK;
+
+    while (!m_stopFlag) {
+        // Every server->client message is an ID-tagged frame:
+        //   [requestId:4][length:4][payload]
+        // where length 0 is end-of-stream, 0xFFFFFFFF an error frame, and
+        // the ID slot carries the opcode for ping/SHM replies.
+        DWORD frame[2] = { 0, 0 };
+        HRESULT hr = BufferedRead(frame, sizeof(frame));
+        if (FAILED(hr)) {
+            fatal = hr;
+            break;
+        }
+
+        DWORD requestId = frame[0];
+        DWORD chunkLength = frame[1];
+
+        if (requestId == OP_PING) {
+            SetEvent(m_hPongEvent);
+            continue;
+        }
+        if (requestId == OP_SETUP_SHM) {
+            m_shmReplyStatus = chunkLength;
+            SetEvent(m_hShmReplyEvent);
+            continue;
+        }
+
+        // Frames for a request that already gave up (cancel deadline) find
+        // no route and are discarded, keeping the connection aligned
+        StreamState* stream = FindRoute(requestId);
+
+        if (chunkLength == 0) {
+            if (stream) {
+                stream->result = S_OK;
+                stream->ring.Push(nullptr, 0, &m_stopFlag);
+            }
+            continue;
+        }
+
+        if (chunkLength == 0xFFFFFFFF) {
+            DWORD errorCode = 0;
+            char errorMsg[256] = { 0 };
+            if (FAILED(BufferedRead(&errorCode, 4)) ||
+                FAILED(BufferedRead(errorMsg, 256))) {
+                fatal = E_UNEXPECTED;
+                break;
+            }
+            if (stream) {
+                stream->result = MapServerError(errorCode);
+                stream->ring.Push(nullptr, 0, &m_stopFlag);
+            }
+            continue;
+        }
+
+        if (chunkLength == META_FRAME) {
+            // Timing metadata: [type][textOffset][textLen]. Routed through
+            // the same ring as the audio so events stay in stream order and
+            // never make the reader wait on event delivery.
+            DWORD meta[3] = { 0, 0, 0 };
+            if (FAILED(BufferedRead(meta, sizeof(meta)))) {
+                fatal = E_UNEXPECTED;
+                break;
+            }
+            if (stream && meta[0] == EVT_WORD_BOUNDARY) {
+                AudioChunkRing::Slot* slot = stream->ring.AcquireSlot(&m_stopFlag);
+                if (!slot) {
+                    fatal = E_ABORT;
+                    break;
+                }
+                slot->external = nullptr;
+                slot->isEvent = true;
+                slot->eventOffset = meta[1];
+                slot->eventLen = meta[2];
+                stream->ring.Publish(1);  // Non-zero: not an end-of-stream
+            }
+            continue;
+        }
+
+        // Sanity check chunk size
+        if (chunkLength > PIPE_BUFFER_SIZE * 10 ||
+            (m_shmActive && chunkLength > SHM_RING_BYTES)) {
+            fatal = E_UNEXPECTED;
+            break;
+        }
+
+        if (m_shmActive) {
+            // Payload already lives in the SHM ring; the pipe frame was only
+            // the signal. The ring cursor advances in frame order no matter
+            // which stream the chunk belongs to.
+            ULONGLONG endPos = 0;
+            const BYTE* data = ShmChunkPtr(chunkLength, endPos);
+            RegisterShmChunk(endPos);
+            if (stream) {
+                AudioChunkRing::Slot* slot = stream->ring.AcquireSlot(&m_stopFlag);
+                if (!slot) {
+                    fatal = E_ABORT;
+                    break;
+                }
+                slot->external = data;
+                slot->shmEnd = endPos;
+                slot->isEvent = false;
+                stream->ring.Publish(chunkLength);
+            }
+            else {
+                ReleaseShmChunk(endPos);
+            }
+        }
+        else if (stream) {
+            // Read chunk data directly into a recycled ring slot - no
+            // per-chunk heap allocation and no intermediate copy
+            AudioChunkRing::Slot* slot = stream->ring.AcquireSlot(&m_stopFlag);
+            if (!slot) {
+                fatal = E_ABORT;
+                break;
+            }
+            slot->external = nullptr;
+            slot->isEvent = false;
+            if (stream->adpcm) {
+                // Wire bytes are ADPCM nibbles; expand them into the slot
+                // here so consumers (and AudioCallback) only ever see PCM
+                m_codecScratch.resize(chunkLength);
+                hr = BufferedRead(m_codecScratch.data(), chunkLength);
+                if (FAILED(hr)) {
+                    fatal = hr;
+                    break;
+                }
+                slot->data.resize(chunkLength * 4);
+                AdpcmDecode(m_codecScratch.data(), chunkLength,
+                            reinterpret_cast<short*>(slot->data.data()),
+                            stream->adpcmPredictor, stream->adpcmIndex);
+                stream->ring.Publish(chunkLength * 4);
+            }
+            else {
+                slot->data.resize(chunkLength);
+                hr = BufferedRead(slot->data.data(), chunkLength);
+                if (FAILED(hr)) {
+                    fatal = hr;
+                    break;
+                }
+                stream->ring.Publish(chunkLength);
+            }
+        }
+        else {
+            discard.resize(chunkLength);
+            hr = BufferedRead(discard.data(), chunkLength);
+            if (FAILED(hr)) {
+                fatal = hr;
+                break;
+            }
+        }
+    }
+
+    // Unblock every in-flight consumer before exiting: set results first so
+    // a consumer that only sees m_readerDead still reads a real HRESULT
+    FailAllRoutes(FAILED(fatal) ? fatal : HRESULT_FROM_WIN32(ERROR_BROKEN_PIPE));
+    m_readerDead = true;
+}
+
+PipeClient::StreamState* PipeClient::FindRoute(DWORD requestId)
+{
+    std::lock_guard<std::mutex> lock(m_routeMutex);
+    for (StreamState* stream : m_routes) {
+        if (stream->requestId == requestId) {
+            return stream;
+        }
+    }
+    return nullptr;
+}
+
+PipeClient::StreamState* PipeClient::AcquireStream()
+{
+    // IDs stay below the opcode range so a tagged frame can never be
+    // mistaken for a ping/SHM reply; zero is reserved
+    static std::atomic<DWORD> s_nextRequestId{ 1 };
+    DWORD requestId;
+    do {
+        requestId = s_nextRequestId.fetch_add(1) & 0x0FFFFFFF;
+    } while (requestId == 0);
+
+    std::lock_guard<std::mutex> lock(m_routeMutex);
+    StreamState* stream = nullptr;
+    for (auto& pooled : m_streamPool) {
+        if (!pooled->inUse) {
+            stream = pooled.get();
+            break;
+        }
+    }
+    if (!stream) {
+        m_streamPool.push_back(std::make_unique<StreamState>());
+        stream = m_streamPool.back().get();
+        // Warm the chunk pool up front so the audio path never allocates
+        stream->ring.Reserve(PIPE_BUFFER_SIZE);
+    }
+    stream->inUse = true;
+    stream->requestId = requestId;
+    stream->result = E_FAIL;
+    stream->failed = false;
+    stream->adpcm = false;
+    stream->adpcmPredictor = 0;
+    stream->adpcmIndex = 0;
+    stream->ring.Reset();
+    m_routes.push_back(stream);
+    return stream;
+}
+
+void PipeClient::ReleaseStream(StreamState* stream)
+{
+    std::lock_guard<std::mutex> lock(m_routeMutex);
+    for (size_t i = 0; i < m_routes.size(); ++i) {
+        if (m_routes[i] == stream) {
+            m_routes.erase(m_routes.begin() + i);
+            break;
+        }
+    }
+    stream->inUse = false;
+}
+
+void PipeClient::FailAllRoutes(HRESULT hr)
+{
+    std::lock_guard<std::mutex> lock(m_routeMutex);
+    for (StreamState* stream : m_routes) {
+        stream->result = hr;
+        stream->failed = true;
+        // Best effort: if the ring is full the consumer is mid-drain and
+        // will notice 'failed' once it empties the ring
+        stream->ring.Push(nullptr, 0, &m_stopFlag);
+    }
+}
+
+void PipeClient::AdpcmDecode(const BYTE* src, DWORD srcBytes, short* dst,
+                             int& predictor, int& stepIndex)
+{
+    // Standard Intel/DVI IMA-ADPCM tables; the server encoder mirrors them
+    static const int s_indexTable[16] = {
+        -1, -1, -1, -1, 2, 4, 6, 8,
+        -1, -1, -1, -1, 2, 4, 6, 8
+    };
+    static const int s_stepTable[89] = {
+        7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+        19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+        50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+        130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+        337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+        876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+        2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+        5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+        15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+    };
+
+    for (DWORD i = 0; i < srcBytes * 2; ++i) {
+        // High nibble carries the earlier sample
+        int delta = (i & 1) ? (src[i >> 1] & 0x0F) : (src[i >> 1] >> 4);
+        int step = s_stepTable[stepIndex];
+        stepIndex += s_indexTable[delta];
+        if (stepIndex < 0) stepIndex = 0;
+        if (stepIndex > 88) stepIndex = 88;
+        int diff = step >> 3;
+        if (delta & 4) diff += step;
+        if (delta & 2) diff += step >> 1;
+        if (delta & 1) diff += step >> 2;
+        predictor += (delta & 8) ? -diff : diff;
+        if (predictor > 32767) predictor = 32767;
+        else if (predictor < -32768) predictor = -32768;
+        *dst++ = static_cast<short>(predictor);
+    }
+}
+
+HRESULT PipeClient::MapServerError(DWORD errorCode)
+{
+    switch (errorCode) {
+    case ERR_EMPTY_TEXT:
+        return E_INVALIDARG;
+    case ERR_INVALID_VOICE:
+        return SPERR_VOICE_NOT_FOUND;
+    case ERR_MODEL_ERROR:
+        return E_FAIL;
+    default:
+        return E_UNEXPECTED;
+    }
+}
+
+
+//=============================================================================
+// CVibeVoiceTTSEngine Implementation
+//=============================================================================
+
+CVibeVoiceTTSEngine::CVibeVoiceTTSEngine()
+{
+}
+
+CVibeVoiceTTSEngine::~CVibeVoiceTTSEngine()
+{
+}
+
+//-----------------------------------------------------------------------------
+// ISpObjectWithToken::SetObjectToken
+// Called by SAPI when the engine is created, provides access to registry data
+//-----------------------------------------------------------------------------
+STDMETHODIMP CVibeVoiceTTSEngine::SetObjectToken(ISpObjectToken* pToken)
+{
+    if (!pToken) {
+        return E_INVALIDARG;
+    }
+
+    m_cpToken = pToken;
+
+    // All token attributes - VoiceId (ASCII for the pipe protocol), the
+    // optional "Priority" scheduling hint, the "Bulk" offline-renderer
+    // marker, and the "Endpoint" server override - come through the
+    // process-wide cache, so a host enumerating voices pays the registry
+    // reads once per token instead of once per engine instance. The cache
+    // invalidates itself on registry change notification.
+    TokenCache::Attributes attrs;
+    TokenCache::Instance().Get(pToken, attrs);
+    m_voiceId = attrs.voiceId;
+    m_priorityFlags = attrs.priorityFlags;
+    m_bulkMode = attrs.bulkMode;
+
+    // The endpoint redirects the client at a non-default server: a custom
+    // local pipe name, a remote pipe (\\server\pipe\vibevoice), or a raw
+    // socket (tcp://host:port) for thin clients talking to an off-box GPU
+    // server. Process-wide because all voices share the connection pool.
+    if (!attrs.endpoint.empty()) {
+        PipeClient::SetEndpoint(attrs.endpoint);
+    }
+
+    // Warm up asynchronously: connect the pipe and have the server load
+    // this voice's KV-cache preset now, so the first Speak hits the model
+    // hot instead of paying 1-2s of connect + preset load. The worker only
+    // touches the process-wide pool and a copied string, so it is safe even
+    // if this engine instance is released before it finishes; the module
+    // reference taken by SpawnModuleThread keeps the DLL's code mapped for
+    // its duration.
+    if (!m_voiceId.empty()) {
+        SpawnModuleThread([voiceId = m_voiceId]() {
+            ConnectionManager::Lease connection = ConnectionManager::Instance().Acquire();
+            connection->PreloadVoice(voiceId.c_str());
+        });
+    }
+
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+// ISpObjectWithToken::GetObjectToken
+//-----------------------------------------------------------------------------
+STDMETHODIMP CVibeVoiceTTSEngine::GetObjectToken(ISpObjectToken** ppToken)
+{
+    if (!ppToken) {
+        return E_POINTER;
+    }
+
+    if (!m_cpToken) {
+        return E_UNEXPECTED;
+    }
+
+    *ppToken = m_cpToken;
+    (*ppToken)->AddRef();
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+// ISpTTSEngine::GetOutputFormat
+// Tells SAPI what audio format we produce
+//-----------------------------------------------------------------------------
+STDMETHODIMP CVibeVoiceTTSEngine::GetOutputFormat(
+    const GUID* pTargetFmtId,
+    const WAVEFORMATEX* pTargetWaveFormatEx,
+    GUID* pOutputFormatId,
+    WAVEFORMATEX** ppCoMemOutputWaveFormatEx)
+{
+    if (!pOutputFormatId || !ppCoMemOutputWaveFormatEx) {
+        return E_POINTER;
+    }
+
+    // Allocate WAVEFORMATEX structure
+    WAVEFORMATEX* pWfx = static_cast<WAVEFORMATEX*>(
+        CoTaskMemAlloc(sizeof(WAVEFORMATEX)));
+    if (!pWfx) {
+        return E_OUTOFMEMORY;
+    }
+
+    // Honor the host's requested rate when our own resampler can produce it
+    // natively. Refusing would put SAPI's generic format converter into the
+    // path - an extra resample and copy per chunk - for every legacy app
+    // that asks for 22.05kHz or 44.1kHz output.
+    DWORD sampleRate = SAMPLE_RATE;
+    if (pTargetFmtId && *pTargetFmtId == SPDFID_WaveFormatEx &&
+        Resampler::CanHandle(pTargetWaveFormatEx)) {
+        sampleRate = pTargetWaveFormatEx->nSamplesPerSec;
+    }
+
+    // Fill in the format: 16-bit mono PCM at the negotiated rate
+    pWfx->wFormatTag = WAVE_FORMAT_PCM;
+    pWfx->nChannels = NUM_CHANNELS;
+    pWfx->nSamplesPerSec = sampleRate;
+    pWfx->wBitsPerSample = BITS_PER_SAMPLE;
+    pWfx->nBlockAlign = (NUM_CHANNELS * BITS_PER_SAMPLE) / 8;
+    pWfx->nAvgBytesPerSec = sampleRate * pWfx->nBlockAlign;
+    pWfx->cbSize = 0;
+
+    *pOutputFormatId = SPDFID_WaveFormatEx;
+    *ppCoMemOutputWaveFormatEx = pWfx;
+
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+// IVibeVoiceStats
+// Session-wide aggregates for the monitoring agent; any engine instance
+// answers for the whole shared counter block
+//-----------------------------------------------------------------------------
+STDMETHODIMP CVibeVoiceTTSEngine::GetStats(VIBEVOICE_STATS* pStats)
+{
+    if (!pStats) {
+        return E_POINTER;
+    }
+    PerfCounters::Instance().Snapshot(*pStats);
+    return S_OK;
+}
+
+STDMETHODIMP CVibeVoiceTTSEngine::ResetStats()
+{
+    PerfCounters::Instance().Reset();
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+// ISpTTSEngine::Speak
+// Main synthesis method - receives text, outputs audio
+//-----------------------------------------------------------------------------
+STDMETHODIMP CVibeVoiceTTSEngine::Speak(
+    DWORD dwSpeakFlags,
+    REFGUID rguidFormatId,
+    const WAVEFORMATEX* pWaveFormatEx,
+    const SPVTEXTFRAG* pTextFragList,
+    ISpTTSEngineSite* pOutputSite)
+{
+    if (!pTextFragList || !pOutputSite) {
+        return E_INVALIDARG;
+    }
+
+    // Convert to the format negotiated in GetOutputFormat. The server
+    // always streams 24kHz; when the host asked for something else the
+    // resampler runs once, vectorized, on the way into Write.
+    if (rguidFormatId == SPDFID_WaveFormatEx &&
+        Resampler::CanHandle(pWaveFormatEx)) {
+        m_resampler.Configure(SAMPLE_RATE, pWaveFormatEx->nSamplesPerSec);
+    }
+    else {
+        m_resampler.Configure(SAMPLE_RATE, SAMPLE_RATE);  // Pass-through
+    }
+
+    // Seed rate/volume from the site - hosts often set both before Speak.
+    // Mid-stream changes arrive via SPVES_RATE/SPVES_VOLUME in GetActions.
+    long rate = 0;
+    USHORT volume = 100;
+    if (SUCCEEDED(pOutputSite->GetRate(&rate))) {
+        m_effects.SetRate(rate);
+    }
+    if (SUCCEEDED(pOutputSite->GetVolume(&volume))) {
+        m_effects.SetVolume(volume);
+    }
+    m_effects.Reset();
+
+    // Reset per-utterance event state and learn what the host wants to hear
+    m_textMap = TextMap();
+    m_normMap.clear();
+    m_nextBookmark = 0;
+    m_bytesWritten = 0;
+    m_eventInterest = 0;
+    pOutputSite->GetEventInterest(&m_eventInterest);
+
+    // Extract all text from the fragment list
+    std::wstring fullText = ExtractText(pTextFragList, m_textMap);
+    TRACE_SPEAK_START(fullText.size());
+
+    // Kick off speculative synthesis for anything the host announced as
+    // coming next, before this utterance starts occupying the Speak thread.
+    // A prefetch-only Speak (no spoken text) is a valid way to warm the
+    // cache, so this runs ahead of the empty-input return below.
+    if (!m_textMap.prefetch.empty()) {
+        StartPrefetch();
+    }
+
+    // Canonical speakable form: digits become words, abbreviations expand,
+    // unstable symbols are stripped and short inputs are padded - all in
+    // the DLL, so the server receives clean text, cache keys are computed
+    // on the same form every host produces, and doomed inputs never cost a
+    // synthesis round trip. The offset map carries event positions back to
+    // the extracted text, and bookmark anchors are rebased forward so all
+    // later comparisons live in one coordinate space.
+    std::wstring spokenText = TextNormalizer::Normalize(fullText, &m_normMap);
+    for (BookmarkMark& mark : m_textMap.bookmarks) {
+        mark.offset = std::lower_bound(m_normMap.begin(), m_normMap.end(),
+                                       mark.offset) - m_normMap.begin();
+    }
+    for (SilenceMark& mark : m_textMap.silences) {
+        mark.offset = std::lower_bound(m_normMap.begin(), m_normMap.end(),
+                                       mark.offset) - m_normMap.begin();
+    }
+
+    // Break the utterance at explicit silence marks, then at sentence
+    // boundaries within each stretch of speech. The pauses themselves never
+    // leave the process, and the speech around them stays one pipelined
+    // Speak call - so a break costs exactly its duration, not a request.
+    struct Segment {
+        std::wstring text;  // Empty for a pause
+        ULONG silenceMs;
+    };
+    std::vector<Segment> segments;
+    {
+        size_t pos = 0;
+        size_t mark = 0;
+        while (pos < spokenText.size() || mark < m_textMap.silences.size()) {
+            size_t cut = mark < m_textMap.silences.size()
+                             ? m_textMap.silences[mark].offset
+                             : spokenText.size();
+            if (cut > spokenText.size()) {
+                cut = spokenText.size();
+            }
+            for (std::wstring& sentence :
+                 SplitSentences(spokenText.substr(pos, cut - pos))) {
+                segments.push_back({ std::move(sentence), 0 });
+            }
+            pos = cut;
+            if (mark < m_textMap.silences.size()) {
+                segments.push_back(
+                    { std::wstring(), m_textMap.silences[mark].msecs });
+                ++mark;
+            }
+        }
+    }
+
+    if (segments.empty()) {
+        FireBookmarksThrough(pOutputSite, spokenText.size());
+        TRACE_SPEAK_STOP(S_OK, m_bytesWritten);
+        return S_OK;  // Nothing to speak (bookmark-only input still fires)
+    }
+
+    // Pipelining: the first speech segment streams to the site while the
+    // next is already synthesizing into a buffer on a second pooled
+    // connection, and so on. This bounds per-request latency, makes an
+    // abort throw away one segment instead of the whole document, and
+    // keeps the GPU busy while the audio device (or a pause) drains.
+    volatile bool prefetchCancel = false;
+    std::vector<BYTE> prefetched;
+    HRESULT prefetchHr = E_FAIL;
+    std::thread prefetchThread;
+    size_t prefetchFor = static_cast<size_t>(-1);  // Segment index the lookahead is for
+
+    // Index of the next speech segment at or after 'from'
+    auto nextSpeech = [&segments](size_t from) {
+        while (from < segments.size() && segments[from].text.empty()) {
+            ++from;
+        }
+        return from;
+    };
+
+    HRESULT hr = S_OK;
+    size_t textBase = 0;    // Segment offsets in the concatenated text
+    bool streamedFirst = false;
+    bool skipInterrupted = false;   // Last write was cut short by SPVES_SKIP
+
+    // Sentence navigation (SPVES_SKIP): reposition the pipeline instead of
+    // making the host abort and re-Speak truncated text - which would pay
+    // connect + prefill + first-audio for every navigation step. The
+    // segment list already is the sentence structure, so a skip just moves
+    // the index; the interrupted sentence's server request was cancelled
+    // (OP_CANCEL parks its generation without touching the connection or
+    // the voice's warm KV cache), skipped-over sentences are never sent,
+    // and the next spoken sentence rides the existing hot connection.
+    auto processSkip = [&](size_t& idx) {
+        SPVSKIPTYPE type;
+        long items = 0;
+        long done = 0;
+        if (SUCCEEDED(pOutputSite->GetSkipInfo(&type, &items)) &&
+            type == SPVST_SENTENCE) {
+            if (skipInterrupted && items > 0) {
+                // The sentence whose playback the skip cut short is the
+                // first item skipped; idx has already moved past it
+                ++done;
+                --items;
+            }
+            while (items > 0) {
+                size_t next = nextSpeech(idx);
+                if (next >= segments.size()) {
+                    break;  // Skip past the end: report what we managed
+                }
+                textBase += segments[next].text.size();
+                idx = next + 1;
+                ++done;
+                --items;
+            }
+            // Backward skip: step over sentences already spoken; they are
+            // still in the segment list and usually still in the audio
+            // cache, so re-speaking them costs no new synthesis
+            while (items < 0 && idx > 0) {
+                --idx;
+                if (!segments[idx].text.empty()) {
+                    textBase -= segments[idx].text.size();
+                    --done;
+                    ++items;
+                }
+            }
+            // Bookmarks inside a skipped-over span still fire, so the
+            // host's position tracking stays consistent
+            if (done > 0) {
+                FireBookmarksThrough(pOutputSite, textBase);
+            }
+        }
+        skipInterrupted = false;
+        pOutputSite->CompleteSkip(done);
+    };
+
+    // Offline rendering has no listener waiting on first audio: skip the
+    // streamed first segment and push everything through the buffered path,
+    // which batches generation on the server and coalesces Writes below
+    if (m_bulkMode) {
+        streamedFirst = true;
+        size_t first = nextSpeech(0);
+        if (first < segments.size()) {
+            const std::wstring text = segments[first].text;
+            prefetchFor = first;
+            prefetchThread = std::thread(
+                [this, text, &prefetched, &prefetchHr, &prefetchCancel]() {
+                    prefetchHr = SynthesizeToBuffer(text, prefetched,
+                                                    &prefetchCancel);
+                });
+        }
+    }
+
+    size_t i = 0;
+    while (i < segments.size()) {
+        if (FAILED(hr)) {
+            break;
+        }
+        DWORD actions = pOutputSite->GetActions();
+        if (actions & SPVES_ABORT) {
+            hr = E_ABORT;
+            break;
+        }
+        if (actions & SPVES_SKIP) {
+            processSkip(i);
+            continue;
+        }
+
+        if (segments[i].text.empty()) {
+            hr = WriteSilence(pOutputSite, segments[i].silenceMs);
+            if (hr == S_FALSE) {
+                // Skip landed mid-pause: the rest of the pause is
+                // discarded, but a pause is not a sentence
+                hr = S_OK;
+            }
+            ++i;
+            continue;
+        }
+
+        // First speech segment streams for lowest first-audio; kick off the
+        // one after it before blocking on playback
+        if (!streamedFirst) {
+            streamedFirst = true;
+            size_t next = nextSpeech(i + 1);
+            if (next < segments.size()) {
+                const std::wstring text = segments[next].text;
+                prefetchFor = next;
+                prefetchThread = std::thread(
+                    [this, text, &prefetched, &prefetchHr, &prefetchCancel]() {
+                        prefetchHr = SynthesizeToBuffer(text, prefetched,
+                                                        &prefetchCancel);
+                    });
+            }
+            hr = SpeakStreaming(segments[i].text, pOutputSite, textBase);
+            textBase += segments[i].text.size();
+            if (hr == S_FALSE) {
+                skipInterrupted = true;
+                hr = S_OK;
+            }
+            ++i;
+            continue;
+        }
+
+        // Collect this segment (usually finished while its predecessor was
+        // playing), then kick off the one after it
+        if (prefetchThread.joinable()) {
+            prefetchThread.join();
+        }
+        std::vector<BYTE> pcm;
+        HRESULT segmentHr = E_FAIL;
+        // A skip may have jumped the index past the sentence the lookahead
+        // was synthesizing; its buffer is for the wrong text then
+        bool haveLookahead = (prefetchFor == i);
+        if (haveLookahead) {
+            pcm.swap(prefetched);
+            segmentHr = prefetchHr;
+        }
+        prefetched.clear();
+
+        size_t next = nextSpeech(i + 1);
+        if (next < segments.size()) {
+            const std::wstring text = segments[next].text;
+            prefetchHr = E_FAIL;
+            prefetchFor = next;
+            prefetchThread = std::thread(
+                [this, text, &prefetched, &prefetchHr, &prefetchCancel]() {
+                    prefetchHr = SynthesizeToBuffer(text, prefetched,
+                                                    &prefetchCancel);
+                });
+        }
+        else {
+            prefetchFor = static_cast<size_t>(-1);
+        }
+
+        if (!haveLookahead) {
+            // Post-skip resume with no usable lookahead: stream this
+            // sentence (cache-aware) for the lowest resume latency
+            hr = SpeakStreaming(segments[i].text, pOutputSite, textBase);
+        }
+        else if (FAILED(segmentHr)) {
+            hr = segmentHr;
+            break;
+        }
+        else {
+            hr = WritePcmToSite(pOutputSite, pcm.data(), pcm.size(),
+                                &m_resampler, &m_effects, &segments[i].text,
+                                textBase);
+        }
+        textBase += segments[i].text.size();
+        if (hr == S_FALSE) {
+            skipInterrupted = true;
+            hr = S_OK;
+        }
+        ++i;
+    }
+
+    // Wind down any in-flight prefetch before returning
+    prefetchCancel = true;
+    if (prefetchThread.joinable()) {
+        prefetchThread.join();
+    }
+    if (SUCCEEDED(hr)) {
+        FireBookmarksThrough(pOutputSite, spokenText.size());
+    }
+    TRACE_SPEAK_STOP(hr, m_bytesWritten);
+    return hr;
+}
+
+//-----------------------------------------------------------------------------
+// WriteSilence - An SSML break as locally generated zero PCM
+//-----------------------------------------------------------------------------
+HRESULT CVibeVoiceTTSEngine::WriteSilence(
+    ISpTTSEngineSite* pOutputSite, ULONG msecs)
+{
+    // A pause shortens with the playback rate like speech does, and the
+    // byte count is computed at the negotiated output rate
+    double seconds = msecs / 1000.0;
+    if (m_effects.Speed() > 0.0f) {
+        seconds /= m_effects.Speed();
+    }
+    ULONGLONG bytes = static_cast<ULONGLONG>(
+        seconds * SAMPLE_RATE * m_resampler.Ratio()) * 2;
+
+    static const BYTE s_zeros[8192] = {};
+    while (bytes > 0) {
+        DWORD actions = pOutputSite->GetActions();
+        if (actions & SPVES_ABORT) {
+            return E_ABORT;
+        }
+        if (actions & SPVES_SKIP) {
+            return S_FALSE;  // Host is navigating; drop the rest of the pause
+        }
+        ULONG chunk = static_cast<ULONG>(
+            bytes < sizeof(s_zeros) ? bytes : sizeof(s_zeros));
+        ULONG bytesWritten = 0;
+        HRESULT hr = pOutputSite->Write(s_zeros, chunk, &bytesWritten);
+        if (FAILED(hr)) {
+            return hr;
+        }
+        m_bytesWritten += bytesWritten;
+        bytes -= chunk;
+    }
+    return S_OK;
+}
+
+//-----------------------------------------------------------------------------
+// SpeakStreaming - Cache-aware streaming synthesis of one sentence
+//-----------------------------------------------------------------------------
+HRESULT CVibeVoiceTTSEngine::SpeakStreaming(
+    const std::wstring& text, ISpTTSEngineSite* pOutputSite, size_t textBase)
+{
+    // Repeated UI strings ("OK button", menu items) hit the shared cache and
+    // go straight to the site with zero pipe traffic and zero GPU work
+    ULONGLONG cacheKey = AudioCache::MakeKey(text, m_voiceId);
+    std::vector<BYTE> cachedPcm;
+    if (AudioCache::Instance().Lookup(cacheKey, cachedPcm)) {
+        return WritePcmToSite(pOutputSite, cachedPcm.data(), cachedPcm.size(),
+                              &m_resampler, &m_effects, &text, textBase);
+    }
+
+    // Set up the audio callback context; capture the stream so a completed
+    // utterance can be inserted into the cache
+    std::vector<BYTE> capture;
+    AudioContext ctx;
+    ctx.pOutputSite = pOutputSite;
+    ctx.audioOffset = 0;
+    ctx.cancelled = false;
+    ctx.skipRequested = false;
+    ctx.capture = &capture;
+    ctx.resampler = &m_resampler;
+    ctx.effects = &m_effects;
+    ctx.engine = this;
+    ctx.textBase = textBase;
+
+    // Stream TTS from the Python server over a pooled connection. All engine
+    // instances in the process share the pool, so concurrent Speak calls get
+    // their own connection instead of queueing behind one. Word-boundary
+    // metadata comes back interleaved with the audio and surfaces as SAPI
+    // events only if the host subscribed to them.
+    bool wantWordEvents =
+        (m_eventInterest & SPFEI(SPEI_WORD_BOUNDARY)) != 0 ||
+        !m_textMap.bookmarks.empty();
+    ConnectionManager::Lease connection = ConnectionManager::Instance().Acquire();
+    HRESULT hr = connection->StreamTTS(
+        text.c_str(),
+        m_voiceId.c_str(),
+        AudioCallback,
+        &ctx,
+        &ctx.cancelled,
+        CancelCheck,
+        m_priorityFlags,
+        wantWordEvents ? WordEventProxy : nullptr
+    );
+
+    // Only complete, uncancelled utterances are worth caching
+    if (hr == S_OK) {
+        AudioCache::Instance().Insert(cacheKey, capture.data(), capture.size());
+    }
+
+    // A skip-triggered cancel is repositioning, not failure: the request
+    // was parked server-side and the Speak loop decides where to resume
+    if (ctx.skipRequested) {
+        return S_FALSE;
+    }
+    return hr;
+}
+
+//-----------------------------------------------------------------------------
+// SynthesizeToBuffer - Cache-aware buffered synthesis of one sentence
+//-----------------------------------------------------------------------------
+HRESULT CVibeVoiceTTSEngine::SynthesizeToBuffer(
+    const std::wstring& text, std::vector<BYTE>& pcm, volatile bool* cancelFlag)
+{
+    ULONGLONG cacheKey = AudioCache::MakeKey(text, m_voiceId);
+    if (AudioCache::Instance().Lookup(cacheKey, pcm)) {
+        return S_OK;
+    }
+
+    // Lookahead synthesis runs ahead of playback, so unless the voice is
+    // explicitly urgent it yields the model to alerts from other engines
+    DWORD flags = m_priorityFlags ? m_priorityFlags : FLAG_PRIORITY_LOW;
+    if (m_bulkMode) {
+        flags |= FLAG_BULK;
+    }
+
+    ConnectionManager::Lease connection = ConnectionManager::Instance().Acquire();
+    HRESULT hr = connection->StreamTTS(
+        text.c_str(),
+        m_voiceId.c_str(),
+        BufferCallback,
+        &pcm,
+        cancelFlag,
+        nullptr,
+        flags
+    );
+
+    if (hr == S_OK) {
+        AudioCache::Instance().Insert(cacheKey, pcm.data(), pcm.size());
+    }
+    return hr;
 }
 
-void PipeClient::Disconnect()
+void CVibeVoiceTTSEngine::BufferCallback(const BYTE* data, DWORD size, void* context)
 {
-    if (m_hPipe != INVALID_HANDLE_VALUE) {
-        CloseHandle(m_hPipe);
-        m_hPipe = INVALID_HANDLE_VALUE;
-    }
+    auto* pcm = static_cast<std::vector<BYTE>*>(context);
+    pcm->insert(pcm->end(), data, data + size);
 }
 
-HRESULT PipeClient::ReadExact(void* buffer, DWORD count)
+//-----------------------------------------------------------------------------
+// SplitSentences - Break text at sentence boundaries
+//-----------------------------------------------------------------------------
+std::vector<std::wstring> CVibeVoiceTTSEngine::SplitSentences(const std::wstring& text)
 {
-    BYTE* ptr = static_cast<BYTE*>(buffer);
-    DWORD remaining = count;
+    // Very short inputs destabilize the model (see model limitations), so
+    // fragments below this length are merged into a neighbor rather than
+    // sent as their own request
+    constexpr size_t MIN_SENTENCE_CHARS = 12;
+
+    std::vector<std::wstring> sentences;
+    std::wstring current;
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        wchar_t ch = text[i];
+        current.push_back(ch);
+
+        bool isTerminator = (ch == L'.' || ch == L'!' || ch == L'?');
+        bool atBoundary = isTerminator &&
+                          (i + 1 == text.size() || iswspace(text[i + 1]));
+        if (atBoundary && current.size() >= MIN_SENTENCE_CHARS) {
+            sentences.push_back(current);
+            current.clear();
+        }
+    }
 
-    while (remaining > 0) {
-        DWORD bytesRead = 0;
-        if (!ReadFile(m_hPipe, ptr, remaining, &bytesRead, NULL)) {
-            return HRESULT_FROM_WIN32(GetLastError());
+    // Trailing text without a terminator
+    if (current.find_first_not_of(L" \t\r\n") != std::wstring::npos) {
+        if (!sentences.empty() && current.size() < MIN_SENTENCE_CHARS) {
+            sentences.back().append(current);
         }
-        if (bytesRead == 0) {
-            return HRESULT_FROM_WIN32(ERROR_BROKEN_PIPE);
+        else {
+            sentences.push_back(current);
         }
-        ptr += bytesRead;
-        remaining -= bytesRead;
     }
 
-    return S_OK;
+    return sentences;
 }
 
-HRESULT PipeClient::WriteExact(const void* buffer, DWORD count)
+//-----------------------------------------------------------------------------
+// ExtractText - Combines all text fragments into a single string
+// Records where each fragment landed (for mapping word-boundary events back
+// to the host's source offsets) and where bookmarks sit between them
+//-----------------------------------------------------------------------------
+std::wstring CVibeVoiceTTSEngine::ExtractText(
+    const SPVTEXTFRAG* pTextFragList, TextMap& map)
 {
-    const BYTE* ptr = static_cast<const BYTE*>(buffer);
-    DWORD remaining = count;
+    std::wstring result;
 
-    while (remaining > 0) {
-        DWORD bytesWritten = 0;
-        if (!WriteFile(m_hPipe, ptr, remaining, &bytesWritten, NULL)) {
-            return HRESULT_FROM_WIN32(GetLastError());
+    for (const SPVTEXTFRAG* pFrag = pTextFragList; pFrag != NULL; pFrag = pFrag->pNext) {
+        // Only process spoken text (not silence, spell-out, etc.)
+        if (pFrag->State.eAction == SPVA_Speak) {
+            if (pFrag->pTextStart && pFrag->ulTextLen > 0) {
+                map.spans.push_back(
+                    { result.size(), pFrag->ulTextLen, pFrag->ulTextSrcOffset });
+                result.append(pFrag->pTextStart, pFrag->ulTextLen);
+            }
+        }
+        else if (pFrag->State.eAction == SPVA_Bookmark) {
+            // The fragment text is the bookmark name; it produces no speech
+            // and fires once the text before it has been spoken
+            std::wstring name;
+            if (pFrag->pTextStart && pFrag->ulTextLen > 0) {
+                name.assign(pFrag->pTextStart, pFrag->ulTextLen);
+            }
+            map.bookmarks.push_back({ result.size(), std::move(name) });
+        }
+        else if (pFrag->State.eAction == SPVA_Silence) {
+            // SSML breaks produce no text; they are honored later with
+            // locally generated zero PCM at this position in the stream
+            if (pFrag->State.SilenceMSecs > 0) {
+                map.silences.push_back(
+                    { result.size(), pFrag->State.SilenceMSecs });
+            }
+        }
+        else if (pFrag->State.eAction == SPVA_ParseUnknownTag) {
+            // SAPI passes XML tags it doesn't recognize straight through to
+            // the engine. Ours announce the host's next utterance so it can
+            // be synthesized speculatively while this one plays.
+            std::wstring tag;
+            if (pFrag->pTextStart && pFrag->ulTextLen > 0) {
+                tag.assign(pFrag->pTextStart, pFrag->ulTextLen);
+            }
+            std::wstring announced;
+            if (ParsePrefetchTag(tag, announced) && !announced.empty()) {
+                map.prefetch.push_back(std::move(announced));
+            }
         }
-        ptr += bytesWritten;
-        remaining -= bytesWritten;
     }
 
-    return S_OK;
+    return result;
 }
 
-HRESULT PipeClient::StreamTTS(
-    LPCWSTR text,
-    LPCSTR voiceId,
-    AudioChunkCallback callback,
-    void* callbackContext,
-    volatile bool* cancelFlag)
+//-----------------------------------------------------------------------------
+// ParsePrefetchTag - Recognize <vibevoice:prefetch text="..."/>
+//-----------------------------------------------------------------------------
+bool CVibeVoiceTTSEngine::ParsePrefetchTag(const std::wstring& tag,
+                                           std::wstring& text)
 {
-    HRESULT hr;
-
-    // Connect if not already connected
-    hr = Connect();
-    if (FAILED(hr)) {
-        return hr;
+    // Accept the tag with or without the namespace prefix; anything else is
+    // some other application's markup and is silently ignored
+    size_t name = tag.find(L"prefetch");
+    if (name == std::wstring::npos) {
+        return false;
     }
 
-    // Prepare text as UTF-16LE
-    size_t textLen = wcslen(text);
-    DWORD textBytes = static_cast<DWORD>(textLen * sizeof(wchar_t));
-
-    // Prepare voice ID (32 bytes, null-padded)
-    char voiceIdPadded[32] = { 0 };
-    if (voiceId) {
-        StringCchCopyA(voiceIdPadded, 32, voiceId);
+    size_t attr = tag.find(L"text", name);
+    if (attr == std::wstring::npos) {
+        return false;
     }
-
-    // Build request
-    // [4 bytes] text_length
-    // [N bytes] text (UTF-16LE)
-    // [32 bytes] voice_id
-    // [4 bytes] flags
-
-    hr = WriteExact(&textBytes, 4);
-    if (FAILED(hr)) goto cleanup;
-
-    hr = WriteExact(text, textBytes);
-    if (FAILED(hr)) goto cleanup;
-
-    hr = WriteExact(voiceIdPadded, 32);
-    if (FAILED(hr)) goto cleanup;
-
-    {
-        DWORD flags = 0;
-        hr = WriteExact(&flags, 4);
-        if (FAILED(hr)) goto cleanup;
+    size_t eq = tag.find(L'=', attr);
+    if (eq == std::wstring::npos) {
+        return false;
     }
-
-    // Read audio chunks
-    while (true) {
-        // Check for cancellation
-        if (cancelFlag && *cancelFlag) {
-            hr = E_ABORT;
-            goto cleanup;
+    size_t open = tag.find_first_of(L"\"'", eq);
+    if (open == std::wstring::npos) {
+        return false;
+    }
+    size_t close = tag.find(tag[open], open + 1);
+    if (close == std::wstring::npos) {
+        return false;
+    }
+    text = tag.substr(open + 1, close - open - 1);
+
+    // Undo the XML escaping the attribute value needed on the way in
+    static const struct { const wchar_t* entity; wchar_t ch; } s_entities[] = {
+        { L"&quot;", L'"' }, { L"&apos;", L'\'' }, { L"&lt;", L'<' },
+        { L"&gt;", L'>' }, { L"&amp;", L'&' },
+    };
+    for (const auto& e : s_entities) {
+        size_t pos = 0;
+        size_t len = wcslen(e.entity);
+        while ((pos = text.find(e.entity, pos)) != std::wstring::npos) {
+            text.replace(pos, len, 1, e.ch);
+            pos += 1;
         }
+    }
+    return true;
+}
 
-        // Read chunk length
-        DWORD chunkLength = 0;
-        hr = ReadExact(&chunkLength, 4);
-        if (FAILED(hr)) goto cleanup;
-
-        // End of stream
-        if (chunkLength == 0) {
-            break;
+//-----------------------------------------------------------------------------
+// StartPrefetch - Background synthesis of announced next utterances
+//-----------------------------------------------------------------------------
+void CVibeVoiceTTSEngine::StartPrefetch()
+{
+    // Bound speculative work process-wide: a host that announces its whole
+    // playlist gets the next few items, not a GPU full of guesses
+    static std::atomic<int> s_inFlight{ 0 };
+    constexpr int MAX_SPECULATIVE = 4;
+
+    for (const std::wstring& utterance : m_textMap.prefetch) {
+        // Normalize and split exactly as the real Speak will, so the cache
+        // keys written here are the ones it looks up
+        for (const std::wstring& sentence :
+             SplitSentences(TextNormalizer::Normalize(utterance))) {
+            if (s_inFlight.load() >= MAX_SPECULATIVE) {
+                return;
+            }
+            ++s_inFlight;
+            // Module-pinned like the voice-preload worker: only copied
+            // strings and process-wide singletons, so it survives engine
+            // release, and SpawnModuleThread keeps the DLL mapped while it
+            // runs. Always low priority - a guess never competes with live
+            // audio.
+            bool spawned = SpawnModuleThread([text = sentence, voiceId = m_voiceId]() {
+                std::vector<BYTE> pcm;
+                ULONGLONG key = AudioCache::MakeKey(text, voiceId);
+                if (!AudioCache::Instance().Lookup(key, pcm)) {
+                    ConnectionManager::Lease connection =
+                        ConnectionManager::Instance().Acquire();
+                    HRESULT hr = connection->StreamTTS(
+                        text.c_str(), voiceId.c_str(), BufferCallback, &pcm,
+                        nullptr, nullptr, FLAG_PRIORITY_LOW);
+                    if (hr == S_OK) {
+                        AudioCache::Instance().Insert(key, pcm.data(), pcm.size());
+                    }
+                }
+                --s_inFlight;
+            });
+            if (!spawned) {
+                --s_inFlight;
+                return;
+            }
         }
+    }
+}
 
-        // Error marker
-        if (chunkLength == 0xFFFFFFFF) {
-            DWORD errorCode = 0;
-            char errorMsg[256] = { 0 };
+//-----------------------------------------------------------------------------
+// AudioCallback - Called for each audio chunk from the server
+//-----------------------------------------------------------------------------
+void CVibeVoiceTTSEngine::AudioCallback(const BYTE* data, DWORD size, void* context)
+{
+    AudioContext* ctx = static_cast<AudioContext*>(context);
+    if (!ctx || !ctx->pOutputSite) {
+        return;
+    }
 
-            ReadExact(&errorCode, 4);
-            ReadExact(errorMsg, 256);
+    // Check if SAPI wants us to abort
+    // GetActions() returns DWORD directly, not via pointer
+    DWORD actions = ctx->pOutputSite->GetActions();
+    if (actions & SPVES_ABORT) {
+        ctx->cancelled = true;
+        return;
+    }
+    // Sentence navigation: stop delivering this sentence's audio; the
+    // cancel tears down only this request, and the Speak loop repositions
+    if (actions & SPVES_SKIP) {
+        ctx->skipRequested = true;
+        ctx->cancelled = true;
+        return;
+    }
+    UpdateEffects(ctx->pOutputSite, actions, ctx->effects);
 
-            // Map error codes to HRESULTs
-            switch (errorCode) {
-            case ERR_EMPTY_TEXT:
-                hr = E_INVALIDARG;
-                break;
-            case ERR_INVALID_VOICE:
-                hr = SPERR_VOICE_NOT_FOUND;
-                break;
-            case ERR_MODEL_ERROR:
-                hr = E_FAIL;
-                break;
-            default:
-                hr = E_UNEXPECTED;
-                break;
-            }
-            goto cleanup;
-        }
+    // Accumulate the utterance for the audio cache. Capture happens before
+    // any DSP: the cache stores native 24kHz full-volume PCM, so a cached
+    // entry can later be replayed at any rate, volume or negotiated format.
+    if (ctx->capture) {
+        ctx->capture->insert(ctx->capture->end(), data, data + size);
+    }
 
-        // Sanity check chunk size
-        if (chunkLength > PIPE_BUFFER_SIZE * 10) {
-            hr = E_UNEXPECTED;
-            goto cleanup;
+    // Rate/volume DSP at the native rate. A stretcher that is still
+    // accumulating input legitimately returns an empty chunk.
+    if (ctx->effects && ctx->effects->Active()) {
+        DWORD processed = 0;
+        data = ctx->effects->Process(data, size, processed);
+        size = processed;
+        if (size == 0) {
+            return;
         }
+    }
 
-        // Read chunk data
-        std::vector<BYTE> chunkData(chunkLength);
-        hr = ReadExact(chunkData.data(), chunkLength);
-        if (FAILED(hr)) goto cleanup;
-
-        // Call the callback with the audio data
-        if (callback) {
-            callback(chunkData.data(), chunkLength, callbackContext);
+    // Convert to the negotiated output format (no-op at 24kHz). The chunk
+    // may legitimately shrink to nothing when downsampling.
+    if (ctx->resampler && ctx->resampler->Active()) {
+        DWORD converted = 0;
+        data = ctx->resampler->Process(data, size, converted);
+        size = converted;
+        if (size == 0) {
+            return;
         }
     }
 
-    hr = S_OK;
-
-cleanup:
-    Disconnect();
-    return hr;
-}
-
+    // Write audio data to SAPI
+    ULONG bytesWritten = 0;
+    const ULONGLONG writeStart = GetTickCount64();
+    HRESULT hr = ctx->pOutputSite->Write(data, size, &bytesWritten);
+    TRACE_SITE_WRITE(size, GetTickCount64() - writeStart);
 
-//=============================================================================
-// CVibeVoiceTTSEngine Implementation
-//=============================================================================
+    if (hr == SP_AUDIO_STOPPED) {
+        ctx->cancelled = true;
+        return;
+    }
 
-CVibeVoiceTTSEngine::CVibeVoiceTTSEngine()
-{
+    ctx->audioOffset += bytesWritten;
+    if (ctx->engine) {
+        ctx->engine->m_bytesWritten += bytesWritten;
+    }
 }
 
-CVibeVoiceTTSEngine::~CVibeVoiceTTSEngine()
+//-----------------------------------------------------------------------------
+// WordEventProxy - StreamTTS word-event callback
+// Runs on the Speak thread between audio chunks (the demux reader only
+// queues), so firing events here can never stall the pipe
+//-----------------------------------------------------------------------------
+void CVibeVoiceTTSEngine::WordEventProxy(DWORD textOffset, DWORD textLen, void* context)
 {
+    AudioContext* ctx = static_cast<AudioContext*>(context);
+    if (!ctx || !ctx->engine || ctx->cancelled) {
+        return;
+    }
+    ctx->engine->FireWordEvent(ctx->pOutputSite, ctx->textBase + textOffset, textLen);
 }
 
 //-----------------------------------------------------------------------------
-// ISpObjectWithToken::SetObjectToken
-// Called by SAPI when the engine is created, provides access to registry data
+// FireWordEvent - Surface one word boundary as SAPI events
 //-----------------------------------------------------------------------------
-STDMETHODIMP CVibeVoiceTTSEngine::SetObjectToken(ISpObjectToken* pToken)
+void CVibeVoiceTTSEngine::FireWordEvent(
+    ISpTTSEngineSite* pOutputSite, size_t concatOffset, size_t length)
 {
-    if (!pToken) {
-        return E_INVALIDARG;
+    // Bookmarks sitting before this word fire first, in text order
+    FireBookmarksThrough(pOutputSite, concatOffset);
+
+    if (!(m_eventInterest & SPFEI(SPEI_WORD_BOUNDARY))) {
+        return;
     }
 
-    m_cpToken = pToken;
+    // Offsets arrive in normalized-text space; step back to the extracted
+    // text first (expansions all point at the token they replaced)
+    if (concatOffset < m_normMap.size()) {
+        concatOffset = m_normMap[concatOffset];
+    }
+    else if (!m_normMap.empty()) {
+        concatOffset = m_normMap.back();
+    }
 
-    // Read voice ID from registry (stored under the token's Attributes key)
-    CSpDynamicString dstrVoiceId;
-    HRESULT hr = pToken->GetStringValue(L"VoiceId", &dstrVoiceId);
-    if (SUCCEEDED(hr) && dstrVoiceId) {
-        // Convert to ASCII for the pipe protocol
-        int len = WideCharToMultiByte(CP_ACP, 0, dstrVoiceId, -1, NULL, 0, NULL, NULL);
-        if (len > 0) {
-            m_voiceId.resize(len);
-            WideCharToMultiByte(CP_ACP, 0, dstrVoiceId, -1, &m_voiceId[0], len, NULL, NULL);
-            // Remove null terminator from string
-            if (!m_voiceId.empty() && m_voiceId.back() == '\0') {
-                m_voiceId.pop_back();
-            }
+    // Map the offset in our concatenated text back to the host's input.
+    // Spans are recorded in text order, so the last span at or before the
+    // offset is the fragment the word came from.
+    ULONG srcOffset = static_cast<ULONG>(concatOffset);
+    for (const SourceSpan& span : m_textMap.spans) {
+        if (span.start > concatOffset) {
+            break;
         }
+        srcOffset = span.srcOffset + static_cast<ULONG>(concatOffset - span.start);
     }
 
-    return S_OK;
+    SPEVENT evt = {};
+    evt.eEventId = SPEI_WORD_BOUNDARY;
+    evt.elParamType = SPET_LPARAM_IS_UNDEFINED;
+    evt.ullAudioStreamOffset = m_bytesWritten;
+    evt.lParam = static_cast<LPARAM>(srcOffset);
+    evt.wParam = static_cast<WPARAM>(length);
+    pOutputSite->AddEvents(&evt, 1);
 }
 
 //-----------------------------------------------------------------------------
-// ISpObjectWithToken::GetObjectToken
+// FireBookmarksThrough - Fire pending bookmarks up to a text position
 //-----------------------------------------------------------------------------
-STDMETHODIMP CVibeVoiceTTSEngine::GetObjectToken(ISpObjectToken** ppToken)
+void CVibeVoiceTTSEngine::FireBookmarksThrough(
+    ISpTTSEngineSite* pOutputSite, size_t concatOffset)
 {
-    if (!ppToken) {
-        return E_POINTER;
-    }
-
-    if (!m_cpToken) {
-        return E_UNEXPECTED;
+    while (m_nextBookmark < m_textMap.bookmarks.size() &&
+           m_textMap.bookmarks[m_nextBookmark].offset <= concatOffset) {
+        const BookmarkMark& mark = m_textMap.bookmarks[m_nextBookmark];
+        if (m_eventInterest & SPFEI(SPEI_TTS_BOOKMARK)) {
+            SPEVENT evt = {};
+            evt.eEventId = SPEI_TTS_BOOKMARK;
+            evt.elParamType = SPET_LPARAM_IS_STRING;
+            evt.ullAudioStreamOffset = m_bytesWritten;
+            evt.lParam = reinterpret_cast<LPARAM>(mark.name.c_str());
+            evt.wParam = static_cast<WPARAM>(_wtol(mark.name.c_str()));
+            pOutputSite->AddEvents(&evt, 1);
+        }
+        ++m_nextBookmark;
     }
-
-    *ppToken = m_cpToken;
-    (*ppToken)->AddRef();
-    return S_OK;
 }
 
 //-----------------------------------------------------------------------------
-// ISpTTSEngine::GetOutputFormat
-// Tells SAPI what audio format we produce
+// FireEstimatedEvents - Word events for buffered PCM
+// Cache hits and prefetched sentences skip the live metadata stream, but
+// their total duration is known, so words are distributed proportionally
+// over the buffer and queued upfront - SAPI fires each event as playback
+// passes its stream offset
 //-----------------------------------------------------------------------------
-STDMETHODIMP CVibeVoiceTTSEngine::GetOutputFormat(
-    const GUID* pTargetFmtId,
-    const WAVEFORMATEX* pTargetWaveFormatEx,
-    GUID* pOutputFormatId,
-    WAVEFORMATEX** ppCoMemOutputWaveFormatEx)
+void CVibeVoiceTTSEngine::FireEstimatedEvents(
+    ISpTTSEngineSite* pOutputSite, const std::wstring& text, size_t textBase,
+    size_t pcmBytes)
 {
-    if (!pOutputFormatId || !ppCoMemOutputWaveFormatEx) {
-        return E_POINTER;
+    bool wantWords = (m_eventInterest & SPFEI(SPEI_WORD_BOUNDARY)) != 0;
+    if (!wantWords && m_textMap.bookmarks.empty()) {
+        return;
     }
 
-    // Allocate WAVEFORMATEX structure
-    WAVEFORMATEX* pWfx = static_cast<WAVEFORMATEX*>(
-        CoTaskMemAlloc(sizeof(WAVEFORMATEX)));
-    if (!pWfx) {
-        return E_OUTOFMEMORY;
+    // Native bytes scale to output-stream bytes by the resampler ratio and
+    // the current playback speed
+    double scale = m_resampler.Ratio();
+    if (m_effects.Speed() > 0.0f) {
+        scale /= m_effects.Speed();
     }
 
-    // Fill in our format: 24kHz, 16-bit, mono PCM
-    pWfx->wFormatTag = WAVE_FORMAT_PCM;
-    pWfx->nChannels = NUM_CHANNELS;
-    pWfx->nSamplesPerSec = SAMPLE_RATE;
-    pWfx->wBitsPerSample = BITS_PER_SAMPLE;
-    pWfx->nBlockAlign = (NUM_CHANNELS * BITS_PER_SAMPLE) / 8;
-    pWfx->nAvgBytesPerSec = SAMPLE_RATE * pWfx->nBlockAlign;
-    pWfx->cbSize = 0;
+    size_t i = 0;
+    while (i < text.size()) {
+        while (i < text.size() && iswspace(text[i])) {
+            ++i;
+        }
+        size_t wordStart = i;
+        while (i < text.size() && !iswspace(text[i])) {
+            ++i;
+        }
+        if (i == wordStart) {
+            break;
+        }
 
-    *pOutputFormatId = SPDFID_WaveFormatEx;
-    *ppCoMemOutputWaveFormatEx = pWfx;
+        ULONGLONG nativePos = text.empty() ? 0 :
+            static_cast<ULONGLONG>(pcmBytes * (static_cast<double>(wordStart) / text.size()));
+        ULONGLONG streamPos = m_bytesWritten +
+            static_cast<ULONGLONG>(nativePos * scale);
 
-    return S_OK;
+        // Reuse the live-event path, but with the interpolated offset
+        ULONGLONG saved = m_bytesWritten;
+        m_bytesWritten = streamPos;
+        FireWordEvent(pOutputSite, textBase + wordStart, i - wordStart);
+        m_bytesWritten = saved;
+    }
 }
 
 //-----------------------------------------------------------------------------
-// ISpTTSEngine::Speak
-// Main synthesis method - receives text, outputs audio
+// UpdateEffects - Pick up rate/volume changes flagged by the site
+// Only the GetRate/GetVolume round trips the site asked for are made, so
+// the steady-state cost of this check is one bit test per chunk
 //-----------------------------------------------------------------------------
-STDMETHODIMP CVibeVoiceTTSEngine::Speak(
-    DWORD dwSpeakFlags,
-    REFGUID rguidFormatId,
-    const WAVEFORMATEX* pWaveFormatEx,
-    const SPVTEXTFRAG* pTextFragList,
-    ISpTTSEngineSite* pOutputSite)
+void CVibeVoiceTTSEngine::UpdateEffects(
+    ISpTTSEngineSite* pOutputSite, DWORD actions, RateVolumeProcessor* effects)
 {
-    if (!pTextFragList || !pOutputSite) {
-        return E_INVALIDARG;
+    if (!effects) {
+        return;
     }
-
-    // Extract all text from the fragment list
-    std::wstring fullText = ExtractText(pTextFragList);
-    if (fullText.empty()) {
-        return S_OK;  // Nothing to speak
+    if (actions & SPVES_RATE) {
+        long rate = 0;
+        if (SUCCEEDED(pOutputSite->GetRate(&rate))) {
+            effects->SetRate(rate);
+        }
+    }
+    if (actions & SPVES_VOLUME) {
+        USHORT volume = 100;
+        if (SUCCEEDED(pOutputSite->GetVolume(&volume))) {
+            effects->SetVolume(volume);
+        }
     }
-
-    // Set up the audio callback context
-    AudioContext ctx;
-    ctx.pOutputSite = pOutputSite;
-    ctx.audioOffset = 0;
-    ctx.cancelled = false;
-
-    // Stream TTS from the Python server
-    HRESULT hr = m_pipeClient.StreamTTS(
-        fullText.c_str(),
-        m_voiceId.c_str(),
-        AudioCallback,
-        &ctx,
-        &ctx.cancelled
-    );
-
-    return hr;
 }
 
 //-----------------------------------------------------------------------------
-// ExtractText - Combines all text fragments into a single string
+// WritePcmToSite - Plays cached PCM, sliced so aborts stay responsive
 //-----------------------------------------------------------------------------
-std::wstring CVibeVoiceTTSEngine::ExtractText(const SPVTEXTFRAG* pTextFragList)
+HRESULT CVibeVoiceTTSEngine::WritePcmToSite(
+    ISpTTSEngineSite* pOutputSite, const BYTE* pcm, size_t size,
+    Resampler* resampler, RateVolumeProcessor* effects,
+    const std::wstring* text, size_t textBase)
 {
-    std::wstring result;
+    // Realtime playback slices small so aborts stay responsive; bulk
+    // speak-to-file rendering has no one to respond to, so it hands the
+    // site eight times as much per Write and spends the savings on call
+    // overhead instead
+    constexpr size_t SLICE_BYTES = 32768;
+    constexpr size_t BULK_SLICE_BYTES = 262144;
+    const size_t sliceLimit = m_bulkMode ? BULK_SLICE_BYTES : SLICE_BYTES;
+
+    // Buffered playback skipped the live metadata stream; queue estimated
+    // word events for the whole buffer before the audio goes out
+    if (text) {
+        FireEstimatedEvents(pOutputSite, *text, textBase, size);
+    }
 
-    for (const SPVTEXTFRAG* pFrag = pTextFragList; pFrag != NULL; pFrag = pFrag->pNext) {
-        // Only process spoken text (not silence, spell-out, etc.)
-        if (pFrag->State.eAction == SPVA_Speak) {
-            if (pFrag->pTextStart && pFrag->ulTextLen > 0) {
-                result.append(pFrag->pTextStart, pFrag->ulTextLen);
-            }
+    size_t offset = 0;
+    while (offset < size) {
+        DWORD actions = pOutputSite->GetActions();
+        if (actions & SPVES_ABORT) {
+            return E_ABORT;
         }
-        else if (pFrag->State.eAction == SPVA_Silence) {
-            // Could insert a pause marker, but for now we just skip
+        if (actions & SPVES_SKIP) {
+            // Sentence navigation: the rest of this sentence's audio is
+            // discarded and the Speak loop repositions the pipeline
+            return S_FALSE;
+        }
+        UpdateEffects(pOutputSite, actions, effects);
+
+        ULONG sliceSize = static_cast<ULONG>(min(sliceLimit, size - offset));
+
+        // Buffered PCM is native 24kHz; rate/volume DSP and format
+        // conversion run per slice on the way out
+        const BYTE* out = pcm + offset;
+        DWORD outSize = sliceSize;
+        if (effects && effects->Active()) {
+            out = effects->Process(out, outSize, outSize);
+        }
+        if (outSize > 0 && resampler && resampler->Active()) {
+            out = resampler->Process(out, outSize, outSize);
         }
+
+        if (outSize > 0) {
+            ULONG bytesWritten = 0;
+            const ULONGLONG writeStart = GetTickCount64();
+            HRESULT hr = pOutputSite->Write(out, outSize, &bytesWritten);
+            TRACE_SITE_WRITE(outSize, GetTickCount64() - writeStart);
+            if (hr == SP_AUDIO_STOPPED) {
+                return E_ABORT;
+            }
+            if (FAILED(hr)) {
+                return hr;
+            }
+            m_bytesWritten += bytesWritten;
+        }
+        offset += sliceSize;
     }
 
-    return result;
+    return S_OK;
 }
 
 //-----------------------------------------------------------------------------
-// AudioCallback - Called for each audio chunk from the server
+// CancelCheck - Polled during pending pipe I/O
+// Lets a user abort (Ctrl in a screen reader) cancel a transfer that is
+// blocked on a stalled server, instead of waiting out the pipe timeout
 //-----------------------------------------------------------------------------
-void CVibeVoiceTTSEngine::AudioCallback(const BYTE* data, DWORD size, void* context)
+bool CVibeVoiceTTSEngine::CancelCheck(void* context)
 {
     AudioContext* ctx = static_cast<AudioContext*>(context);
     if (!ctx || !ctx->pOutputSite) {
-        return;
+        return false;
+    }
+
+    if (ctx->cancelled) {
+        return true;
     }
 
-    // Check if SAPI wants us to abort
-    // GetActions() returns DWORD directly, not via pointer
     DWORD actions = ctx->pOutputSite->GetActions();
     if (actions & SPVES_ABORT) {
         ctx->cancelled = true;
-        return;
+        return true;
     }
-
-    // Write audio data to SAPI
-    ULONG bytesWritten = 0;
-    HRESULT hr = ctx->pOutputSite->Write(data, size, &bytesWritten);
-
-    if (hr == SP_AUDIO_STOPPED) {
+    if (actions & SPVES_SKIP) {
+        ctx->skipRequested = true;
         ctx->cancelled = true;
-        return;
+        return true;
     }
 
-    ctx->audioOffset += bytesWritten;
+    return false;
 }
 
 
@@ -425,6 +2367,13 @@ void CVibeVoiceTTSEngine::AudioCallback(const BYTE* data, DWORD size, void* cont
 
 extern "C" BOOL WINAPI DllMain(HINSTANCE hInstance, DWORD dwReason, LPVOID lpReserved)
 {
+    // ETW registration is explicitly DllMain-safe
+    if (dwReason == DLL_PROCESS_ATTACH) {
+        TraceRegister();
+    }
+    else if (dwReason == DLL_PROCESS_DETACH) {
+        TraceUnregister();
+    }
     return _AtlModule.DllMain(dwReason, lpReserved);
 }
 
@@ -7,23 +7,37 @@
 // Suppress deprecated API warnings from sphelper.h
 #pragma warning(disable: 4996)
 
+// winsock2.h must precede windows.h so the legacy winsock.h never loads
+#include <winsock2.h>
+#include <ws2tcpip.h>
 #include <windows.h>
 #include <sapi.h>
 #include <sapiddk.h>
 #include <sphelper.h>
 #include <atlbase.h>
 #include <atlcom.h>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "resource.h"
+#include "AudioEffects.h"
+#include "PerfCounters.h"
+#include "Resampler.h"
 
 // {A1B2C3D4-E5F6-7890-ABCD-EF1234567890}
 // Generate a new GUID for your installation using guidgen.exe or uuidgen
 extern const GUID CLSID_VibeVoiceTTSEngine_Impl;
 #define CLSID_VibeVoiceTTSEngine CLSID_VibeVoiceTTSEngine_Impl
 
-// Pipe communication constants
+// Pipe communication constants. PIPE_NAME is only the default endpoint -
+// a voice token's "Endpoint" attribute can redirect every connection to a
+// remote pipe or a TCP socket (see PipeClient::SetEndpoint).
 constexpr wchar_t PIPE_NAME[] = L"\\\\.\\pipe\\vibevoice";
 constexpr DWORD PIPE_BUFFER_SIZE = 65536;
 constexpr DWORD PIPE_TIMEOUT_MS = 30000;  // 30 second timeout
@@ -33,6 +47,80 @@ constexpr DWORD SAMPLE_RATE = 24000;
 constexpr WORD BITS_PER_SAMPLE = 16;
 constexpr WORD NUM_CHANNELS = 1;
 
+// Protocol opcodes (client -> server, sent in place of the text length field).
+// Values are kept in the top of the DWORD range so they can never collide
+// with a real text length - or, on the return path, with a request ID.
+constexpr DWORD OP_PING = 0xFFFFFFF0;
+constexpr DWORD OP_CANCEL = 0xFFFFFFF1;  // Followed by the 4-byte request ID
+constexpr DWORD OP_PRELOAD_VOICE = 0xFFFFFFF2;
+constexpr DWORD OP_REQUEST_V2 = 0xFFFFFFF3;
+constexpr DWORD OP_SETUP_SHM = 0xFFFFFFF4;
+constexpr DWORD OP_CREDIT = 0xFFFFFFF5;  // [requestId:4][count:4] - grant chunks
+
+// Request flags (RequestHeaderV2::flags)
+constexpr DWORD FLAG_SHM_AUDIO = 0x00000002;  // Audio payload rides the SHM ring
+// Scheduling priority: the server serves the highest-priority waiter first
+// and lets urgent requests cut in between a background stream's chunks.
+// Neither bit set means normal priority.
+constexpr DWORD FLAG_PRIORITY_HIGH = 0x00000004;  // Alerts/interactive prompts
+constexpr DWORD FLAG_PRIORITY_LOW = 0x00000008;   // Background narration, lookahead
+// Credit-based flow control: the server starts with its configured window of
+// chunk credits and stops generating when they run out; the client grants
+// more (OP_CREDIT) as playback drains the ring. Bounds server lookahead to
+// roughly the ring depth, so skipped utterances stop wasting GPU quickly.
+constexpr DWORD FLAG_FLOW_CONTROL = 0x00000010;
+constexpr DWORD CREDIT_BATCH = 4;   // Chunks consumed per credit grant
+// Ask the server to interleave word-boundary metadata frames with the audio,
+// which the engine turns into SPEI_WORD_BOUNDARY events for word highlighting
+constexpr DWORD FLAG_WORD_EVENTS = 0x00000020;
+// Ask the server to IMA-ADPCM compress audio chunks (4 bits per sample,
+// ~4x fewer wire bytes). Negotiated automatically for remote endpoints,
+// where WAN bandwidth dominates time-to-first-audio; the local pipe stays
+// uncompressed. Codec state runs across chunks, so frames must be decoded
+// in arrival order - which the per-request ring already guarantees.
+constexpr DWORD FLAG_ADPCM_AUDIO = 0x00000040;
+// Bulk/offline mode for speak-to-file rendering: nobody is listening live,
+// so the server batches generation into large frames and the client
+// coalesces playback into large Writes. Optimizes utterances per hour at
+// the cost of the first-audio latency realtime callers care about.
+constexpr DWORD FLAG_BULK = 0x00000080;
+
+// Length-field sentinel on the response path: the frame carries timing
+// metadata ([type:4][textOffset:4][textLen:4]) instead of an audio chunk
+constexpr DWORD META_FRAME = 0xFFFFFFFE;
+constexpr DWORD EVT_WORD_BOUNDARY = 1;
+
+// Shared-memory audio path: control frames stay on the pipe, PCM lands in a
+// per-connection file-mapping ring. Layout: [writePos:8][readPos:8][data].
+// Chunks never wrap - a writer that doesn't fit skips to the ring start, and
+// the reader mirrors the same rule - so consumers always see contiguous
+// chunks and can hand SAPI a pointer straight into the mapping.
+constexpr DWORD SHM_RING_BYTES = 1 << 20;   // 1 MB of PCM lookahead
+constexpr DWORD SHM_HEADER_BYTES = 16;
+
+// Versioned request framing (protocol v2). The whole request - header plus
+// UTF-16LE text - is serialized into one buffer and written with a single
+// WriteFile. headerBytes lets future versions append fields without adding
+// syscalls: old servers skip bytes they don't understand.
+//
+// Every v2 response frame from the server is prefixed with the request ID it
+// belongs to, so any number of requests can be in flight on one connection
+// and a demultiplexing reader routes the frames back to their callers.
+constexpr WORD PROTOCOL_VERSION = 2;
+
+#pragma pack(push, 1)
+struct RequestHeaderV2
+{
+    DWORD opcode;       // OP_REQUEST_V2
+    WORD  version;      // PROTOCOL_VERSION
+    WORD  headerBytes;  // sizeof(RequestHeaderV2) at the sender's version
+    DWORD textBytes;    // Length of the UTF-16LE text that follows
+    DWORD flags;
+    char  voiceId[32];  // Null-padded ASCII voice ID
+    DWORD requestId;    // Echoed in every response frame for this request
+};
+#pragma pack(pop)
+
 // Error codes from Python server
 constexpr DWORD ERR_EMPTY_TEXT = 1;
 constexpr DWORD ERR_INVALID_VOICE = 2;
@@ -44,8 +132,89 @@ constexpr DWORD ERR_UNKNOWN = 99;
 class CVibeVoiceTTSEngine;
 
 
+//-----------------------------------------------------------------------------
+// SpawnModuleThread - Detached worker that can't outlive the DLL's code
+//
+// Background work (voice preload, speculative prefetch, the registry
+// watcher) runs DLL code without holding the ATL module lock, and
+// DllCanUnloadNow only consults that lock - so a host calling
+// CoFreeUnusedLibraries could unmap the DLL underneath a live worker.
+// The spawn takes a module reference on the worker's behalf and the
+// worker releases it as its very last instruction
+// (FreeLibraryAndExitThread), keeping the code resident for exactly as
+// long as any worker is running. Returns false (and never runs the
+// work) when the reference or the thread can't be obtained - background
+// work is always optional.
+//-----------------------------------------------------------------------------
+bool SpawnModuleThread(std::function<void()> work);
+
+
+//-----------------------------------------------------------------------------
+// AudioChunkRing - Single-producer/single-consumer ring of audio chunks
+//
+/// Decouples pipe reads from ISpTTSEngineSite::Write: the reader thread keeps
+// pulling chunks off the pipe while the Speak thread drains the ring into
+// the (possibly blocking) audio device. Indices are lock-free atomics; the
+// events are only used for sleeping when the ring is full/empty.
+//-----------------------------------------------------------------------------
+class AudioChunkRing
+{
+public:
+    AudioChunkRing();
+    ~AudioChunkRing();
+
+    struct Slot {
+        std::vector<BYTE> data;
+        DWORD size = 0;             // 0 marks end of stream
+        const BYTE* external = nullptr;  // Payload in the SHM ring (no copy)
+        ULONGLONG shmEnd = 0;       // Ring position to release after consume
+        // Timing metadata rides the same ring as the audio so events are
+        // delivered in stream order without ever blocking the reader
+        bool isEvent = false;
+        DWORD eventOffset = 0;      // Word start, UTF-16 units into the text
+        DWORD eventLen = 0;         // Word length
+    };
+
+    // Producer: borrow the next free slot to fill in place, blocking while
+    // the ring is full. Returns nullptr if cancelled while waiting. Call
+    // Publish() once the slot holds valid data.
+    Slot* AcquireSlot(volatile bool* cancelFlag);
+    void Publish(DWORD size);
+
+    // Producer convenience: copy a chunk in (a zero-size push marks end of
+    // stream). Returns false if cancelled.
+    bool Push(const BYTE* data, DWORD size, volatile bool* cancelFlag);
+
+    // Consumer: borrow the next published slot, waiting up to waitMs.
+    // Returns nullptr on timeout. Call Consume() once done with the slot.
+    Slot* Pop(DWORD waitMs);
+    void Consume();
+
+    // Pre-reserve every slot's buffer so the steady-state audio path never
+    // touches the heap
+    void Reserve(size_t bytesPerSlot);
+
+    // Rewind the indices for a new utterance; slot buffers keep their
+    // capacity across utterances
+    void Reset();
+
+private:
+    static constexpr size_t SLOT_COUNT = 16;
+    Slot m_slots[SLOT_COUNT];
+    std::atomic<size_t> m_writeIndex{ 0 };
+    std::atomic<size_t> m_readIndex{ 0 };
+    HANDLE m_hDataEvent;   // Signalled when a slot is published
+    HANDLE m_hSpaceEvent;  // Signalled when a slot is consumed
+};
+
+
 //-----------------------------------------------------------------------------
 // PipeClient - Handles communication with the Python TTS server
+//
+// One connection carries any number of concurrent requests: a demultiplexing
+// reader thread owns all pipe reads and routes ID-tagged frames into
+// per-request rings, while writes (requests, cancels, pings) are serialized
+// by a mutex. Callers of StreamTTS never see each other.
 //-----------------------------------------------------------------------------
 class PipeClient
 {
@@ -53,7 +222,14 @@ public:
     PipeClient();
     ~PipeClient();
 
-    // Connect to the named pipe server
+    // Process-wide transport endpoint, shared by every pooled connection.
+    // Accepts a named-pipe path - local (\\.\pipe\vibevoice) or remote
+    // (\\server\pipe\vibevoice) - or "tcp://host:port" for a raw socket
+    // with TCP_NODELAY. Set from the voice token's "Endpoint" attribute;
+    // thin clients point it at the GPU box one rack over.
+    static void SetEndpoint(const std::wstring& endpoint);
+
+    // Connect to the configured server endpoint
     HRESULT Connect();
 
     // Disconnect from the pipe
@@ -62,25 +238,190 @@ public:
     // Check if connected
     bool IsConnected() const { return m_hPipe != INVALID_HANDLE_VALUE; }
 
+    // Cheap keep-alive round trip to verify the server is still alive on a
+    // cached connection. Disconnects the pipe on failure.
+    HRESULT Ping();
+
+    // Ask the server to load a voice's KV-cache preset ahead of the first
+    // Speak. Fire-and-forget: the server sends no reply.
+    HRESULT PreloadVoice(LPCSTR voiceId);
+
+    // Signal abort from another thread. Cancels any in-flight overlapped
+    // read/write via CancelIoEx, so a blocked StreamTTS returns within
+    // milliseconds instead of waiting out the pipe timeout.
+    void Abort();
+
     // Send TTS request and stream audio back via callback
     // Returns S_OK on success, error HRESULT on failure
     typedef void (*AudioChunkCallback)(const BYTE* data, DWORD size, void* context);
+    // Polled while I/O is pending; return true to cancel the transfer
+    typedef bool (*CancelCheckCallback)(void* context);
+    // Word-boundary metadata, delivered between the audio chunks it times.
+    // Passing a callback makes StreamTTS request FLAG_WORD_EVENTS.
+    typedef void (*WordEventCallback)(DWORD textOffset, DWORD textLen, void* context);
     HRESULT StreamTTS(
         LPCWSTR text,
         LPCSTR voiceId,
         AudioChunkCallback callback,
         void* callbackContext,
-        volatile bool* cancelFlag = nullptr
+        volatile bool* cancelFlag = nullptr,
+        CancelCheckCallback cancelCheck = nullptr,
+        DWORD requestFlags = 0,
+        WordEventCallback eventCallback = nullptr
     );
 
 private:
-    HANDLE m_hPipe;
+    // Endpoint shared across the connection pool (guarded by its mutex);
+    // empty means the default local pipe
+    static std::mutex s_endpointMutex;
+    static std::wstring s_endpoint;
+    static std::wstring GetEndpoint();
+
+    // Open a TCP connection to "tcp://host:port" with TCP_NODELAY. The
+    // resulting socket handle supports the same overlapped ReadFile/
+    // WriteFile and CancelIoEx paths as a pipe handle, so everything above
+    // Connect() is transport-agnostic.
+    HRESULT ConnectTcp(const std::wstring& endpoint);
 
-    // Read exactly 'count' bytes from the pipe
-    HRESULT ReadExact(void* buffer, DWORD count);
+    HANDLE m_hPipe;
+    bool m_isSocket = false;    // m_hPipe is a SOCKET (close accordingly)
+    HANDLE m_hReadEvent;    // Overlapped completion for the demux reader
+    HANDLE m_hWriteEvent;   // Overlapped completion for (serialized) writers
+    HANDLE m_hAbortEvent;   // Manual-reset; set by Abort()
+
+    // Opcode replies arrive on the demux reader and are handed to whichever
+    // caller is waiting via these events
+    HANDLE m_hPongEvent;        // OP_PING echoed back
+    HANDLE m_hShmReplyEvent;    // OP_SETUP_SHM acknowledged
+    DWORD m_shmReplyStatus;
+
+    // Serializes Connect/Disconnect/SetupSharedMemory against each other -
+    // concurrent StreamTTS calls may race to repair a dead connection
+    std::mutex m_lifecycleMutex;
+
+    // One writer at a time on the pipe; requests, cancels and pings from
+    // concurrent streams interleave at whole-message granularity
+    std::mutex m_writeMutex;
+
+    // Pooled scratch buffer for serializing requests (under m_writeMutex)
+    std::vector<BYTE> m_requestBuffer;
+
+    // --- Demultiplexing (one reader thread per connection) ---
+    //
+    // Each in-flight request owns a StreamState: the reader routes frames by
+    // request ID into its ring, and the StreamTTS caller consumes only its
+    // own. States are pooled so rings keep their warmed buffers.
+    struct StreamState {
+        DWORD requestId = 0;
+        AudioChunkRing ring;
+        HRESULT result = E_FAIL;    // Valid once the end-of-stream slot pops
+        volatile bool failed = false;   // Reader died; drain and give up
+        bool inUse = false;
+        // ADPCM decoder state, continuous across this request's chunks
+        bool adpcm = false;
+        int adpcmPredictor = 0;
+        int adpcmIndex = 0;
+    };
 
-    // Write exactly 'count' bytes to the pipe
-    HRESULT WriteExact(const void* buffer, DWORD count);
+    std::thread m_readerThread;
+    volatile bool m_stopFlag;       // Tells the reader (and ring waits) to bail
+    volatile bool m_readerDead;     // Reader exited - connection is unusable
+    std::mutex m_routeMutex;
+    std::vector<StreamState*> m_routes;                      // In flight
+    std::vector<std::unique_ptr<StreamState>> m_streamPool;  // Warm rings
+
+    // Frame-read loop run on the reader thread: reads [requestId][length]
+    // frames and routes chunks, errors and end-of-stream markers to the
+    // matching request's ring. On I/O failure it fails every route.
+    void DemuxLoop();
+
+    StreamState* FindRoute(DWORD requestId);
+    StreamState* AcquireStream();
+    void ReleaseStream(StreamState* stream);
+    void FailAllRoutes(HRESULT hr);
+    static HRESULT MapServerError(DWORD errorCode);
+
+    // Expand IMA-ADPCM nibbles (high nibble first) into 16-bit PCM. The
+    // predictor chain is sequential sample to sample, so this is a tight
+    // scalar loop; at 4 bits per sample it is far from the hot path anyway.
+    static void AdpcmDecode(const BYTE* src, DWORD srcBytes, short* dst,
+                            int& predictor, int& stepIndex);
+    std::vector<BYTE> m_codecScratch;   // Reader-thread wire-side buffer
+
+    // Ask the server to stop generating one request. Its stream still ends
+    // with a tagged end-of-stream frame, so no drain or realignment is
+    // needed - the demux reader just keeps routing.
+    void SendCancel(DWORD requestId);
+
+    // Grant the server 'count' more chunks of generation credit
+    void SendCredit(DWORD requestId, DWORD count);
+
+    // Shared-memory audio path (negotiated per connection, best effort)
+    HANDLE m_hShmMapping;
+    HANDLE m_hShmSpaceEvent;
+    BYTE* m_shmView;
+    bool m_shmActive;
+    ULONGLONG m_shmReadPos;     // Reader-thread cursor into the ring
+
+    // Ring space must be released in arrival order even though concurrent
+    // consumers finish their chunks out of order. The reader appends each
+    // chunk's end position here; consumers mark theirs released and only
+    // the fully-released prefix is published to the server.
+    std::mutex m_shmQueueMutex;
+    std::deque<std::pair<ULONGLONG, bool>> m_shmQueue;  // (endPos, released)
+
+    // Negotiate the SHM ring with the server after a fresh connect.
+    // Teardown assumes m_lifecycleMutex is held by the caller.
+    void SetupSharedMemory();
+    void TeardownSharedMemory();
+
+    // Reader thread: resolve the next contiguous chunk pointer in the ring
+    const BYTE* ShmChunkPtr(DWORD size, ULONGLONG& endPos);
+
+    // Publish the released prefix to the server and wake its writer.
+    // Callers hold m_shmQueueMutex.
+    void ShmPublishReadPos(ULONGLONG pos);
+
+    void RegisterShmChunk(ULONGLONG endPos);    // Reader, arrival order
+    void ReleaseShmChunk(ULONGLONG endPos);     // Consumers, any order
+
+    // Overlapped read/write of exactly 'count' bytes, cancellable via the
+    // abort event (reads also honor m_stopFlag)
+    HRESULT Transfer(bool isRead, void* buffer, DWORD count);
+
+    // One overlapped ReadFile/WriteFile, same cancellation semantics as
+    // Transfer. Reads may complete short: the transport hands over whatever
+    // it has buffered, which is what the batched receive path wants.
+    HRESULT IoOnce(bool isRead, void* buffer, DWORD count, DWORD& transferred);
+
+    // Batched receive path for the demux reader: one large read drains
+    // everything the transport has pending into the staging buffer, and the
+    // framing parser consumes [id][len][payload] records from it without
+    // further kernel transitions - syscalls scale with pipe occupancy, not
+    // with the server's chunk granularity. (PeekNamedPipe would serve the
+    // same purpose but doesn't exist for sockets; a short overlapped read
+    // is transport-agnostic.) Payloads at least the size of the staging
+    // buffer are read straight into their destination instead.
+    HRESULT BufferedRead(void* buffer, DWORD count);
+    std::vector<BYTE> m_rxBuffer;
+    size_t m_rxHead = 0;
+    size_t m_rxTail = 0;
+
+    // Tear down the connection with m_lifecycleMutex already held
+    void DisconnectLocked();
+
+    // Tear down only if the reader really is dead - re-checked under the
+    // lock so a racing reconnect isn't torn down by a stale observation
+    void DisconnectIfDead();
+
+    // Read exactly 'count' bytes from the pipe (demux reader only)
+    HRESULT ReadExact(void* buffer, DWORD count) { return Transfer(true, buffer, count); }
+
+    // Write exactly 'count' bytes to the pipe (callers hold m_writeMutex)
+    HRESULT WriteExact(const void* buffer, DWORD count)
+    {
+        return Transfer(false, const_cast<void*>(buffer), count);
+    }
 };
 
 
@@ -91,7 +432,8 @@ class ATL_NO_VTABLE CVibeVoiceTTSEngine :
     public CComObjectRootEx<CComMultiThreadModel>,
     public CComCoClass<CVibeVoiceTTSEngine, &CLSID_VibeVoiceTTSEngine>,
     public ISpTTSEngine,
-    public ISpObjectWithToken
+    public ISpObjectWithToken,
+    public IVibeVoiceStats
 {
 public:
     CVibeVoiceTTSEngine();
@@ -103,6 +445,7 @@ public:
     BEGIN_COM_MAP(CVibeVoiceTTSEngine)
         COM_INTERFACE_ENTRY(ISpTTSEngine)
         COM_INTERFACE_ENTRY(ISpObjectWithToken)
+        COM_INTERFACE_ENTRY_IID(__uuidof(IVibeVoiceStats), IVibeVoiceStats)
     END_COM_MAP()
 
     DECLARE_PROTECT_FINAL_CONSTRUCT()
@@ -130,23 +473,172 @@ public:
         WAVEFORMATEX** ppCoMemOutputWaveFormatEx
     ) override;
 
+    // IVibeVoiceStats - process/session aggregate counters for monitoring
+    STDMETHODIMP GetStats(VIBEVOICE_STATS* pStats) override;
+    STDMETHODIMP ResetStats() override;
+
 private:
     CComPtr<ISpObjectToken> m_cpToken;
     std::string m_voiceId;  // Voice ID from registry (e.g., "en-Carter_man")
-    PipeClient m_pipeClient;
 
-    // Helper to extract all text from SPVTEXTFRAG linked list
-    std::wstring ExtractText(const SPVTEXTFRAG* pTextFragList);
+    // Priority flag for this voice's requests, from the token's optional
+    // "Priority" attribute ("High"/"Low"). SAPI keeps SPVPRIORITY to
+    // itself - engines never see it - so the token is the knob kiosk
+    // deployments use to mark their alert voice as urgent.
+    DWORD m_priorityFlags = 0;
+
+    // "Bulk" token attribute: this voice renders to files (nightly
+    // announcement batches), so throughput beats first-audio latency -
+    // everything goes through the buffered path with FLAG_BULK on the wire
+    bool m_bulkMode = false;
+
+    // Converts 24kHz model output to the format negotiated in
+    // GetOutputFormat, so SAPI's generic converter stays out of the hot
+    // path. Inactive when the host accepts 24kHz. Speak is serialized per
+    // engine instance, so one streaming converter per engine suffices.
+    Resampler m_resampler;
+
+    // Rate (WSOLA time-stretch) and volume stages, driven by the site's
+    // GetRate/GetVolume. Runs at the native 24kHz ahead of the resampler.
+    RateVolumeProcessor m_effects;
+
+    // --- Word-boundary / bookmark event state (reset per Speak) ---
+    //
+    // Word events carry text offsets relative to the host's original input,
+    // so the concatenated text we send to the server is mapped back to
+    // fragment source offsets. Bookmarks are fragments, not text: they are
+    // recorded at their position in the concatenated text and fired once
+    // the surrounding words have been spoken.
+    struct SourceSpan {
+        size_t start;       // Offset in the concatenated text
+        size_t length;
+        ULONG srcOffset;    // Matching ulTextSrcOffset in the host's input
+    };
+    struct BookmarkMark {
+        size_t offset;      // Position in the concatenated text
+        std::wstring name;
+    };
+    struct SilenceMark {
+        size_t offset;      // Position in the concatenated text
+        ULONG msecs;
+    };
+    struct TextMap {
+        std::vector<SourceSpan> spans;
+        std::vector<BookmarkMark> bookmarks;
+        // SSML breaks, honored locally with zero PCM at their position
+        std::vector<SilenceMark> silences;
+        // Utterances the host announced as coming next (prefetch tags);
+        // they produce no speech in this Speak call
+        std::vector<std::wstring> prefetch;
+    };
+
+    TextMap m_textMap;
+    // Normalized-text index -> extracted-text index (one entry per
+    // normalized character); word-event offsets step through it before the
+    // span lookup above. Empty means nothing was normalized this utterance.
+    std::vector<size_t> m_normMap;
+    size_t m_nextBookmark = 0;      // First bookmark not yet fired
+    ULONGLONG m_bytesWritten = 0;   // Output bytes written to the site
+    ULONGLONG m_eventInterest = 0;  // From GetEventInterest at Speak start
+
+    // Translate a word boundary in the concatenated text into SAPI events:
+    // any bookmarks passed along the way, then SPEI_WORD_BOUNDARY with the
+    // host's source offset. AddEvents only queues, so this never blocks the
+    // audio path.
+    void FireWordEvent(ISpTTSEngineSite* pOutputSite, size_t concatOffset,
+                       size_t length);
+
+    // Fire every bookmark at or before concatOffset (end = fire them all)
+    void FireBookmarksThrough(ISpTTSEngineSite* pOutputSite, size_t concatOffset);
+
+    // Generate estimated word events for buffered PCM (cache hits and
+    // prefetched sentences), distributing words over the known duration
+    void FireEstimatedEvents(ISpTTSEngineSite* pOutputSite,
+                             const std::wstring& text, size_t textBase,
+                             size_t pcmBytes);
+
+    // Extract all text from the SPVTEXTFRAG linked list, recording source
+    // offsets and bookmarks into the map
+    std::wstring ExtractText(const SPVTEXTFRAG* pTextFragList, TextMap& map);
+
+    // Split extracted text at sentence boundaries for pipelined synthesis.
+    // Fragments too short to synthesize stably are merged into a neighbor.
+    static std::vector<std::wstring> SplitSentences(const std::wstring& text);
+
+    // Synthesize one sentence, streaming chunks to the site as they arrive
+    // (cache-aware). textBase is the sentence's offset in the concatenated
+    // text, used to rebase word-event offsets. Used for single-sentence
+    // input and the first sentence of a pipeline, where first-audio latency
+    // matters most.
+    HRESULT SpeakStreaming(const std::wstring& text, ISpTTSEngineSite* pOutputSite,
+                           size_t textBase = 0);
+
+    // Synthesize one sentence into a PCM buffer (cache-aware), used to
+    // prefetch sentence N+1 while sentence N is playing
+    HRESULT SynthesizeToBuffer(const std::wstring& text, std::vector<BYTE>& pcm,
+                               volatile bool* cancelFlag);
+
+    // StreamTTS callback that just accumulates PCM into a vector
+    static void BufferCallback(const BYTE* data, DWORD size, void* context);
+
+    // Write an SSML break as zero-filled PCM from a static buffer - no
+    // allocation, no pipe traffic. Duration scales with playback rate and
+    // the byte count is computed at the negotiated output rate.
+    HRESULT WriteSilence(ISpTTSEngineSite* pOutputSite, ULONG msecs);
+
+    // Speculative synthesis of utterances the host told us are coming next
+    // (list navigation, queued announcements). Hosts embed
+    //   <vibevoice:prefetch text="the next line"/>
+    // in their input; SAPI hands the unknown tag through as a fragment, and
+    // each announced utterance is synthesized in the background at low
+    // priority into the shared audio cache. When the real Speak for that
+    // text arrives it hits the cache, dropping the inter-utterance gap from
+    // model latency to near zero.
+    void StartPrefetch();
+
+    // Pull the text attribute out of a prefetch tag; false if the tag is
+    // something else (which we ignore, as SAPI engines are expected to)
+    static bool ParsePrefetchTag(const std::wstring& tag, std::wstring& text);
 
     // Audio callback context
     struct AudioContext {
         ISpTTSEngineSite* pOutputSite;
         ULONGLONG audioOffset;
         volatile bool cancelled;
+        // The cancel was a sentence skip (SPVES_SKIP), not an abort: the
+        // Speak loop repositions instead of unwinding
+        volatile bool skipRequested;
+        std::vector<BYTE>* capture;  // Accumulates PCM for the cache (optional)
+        Resampler* resampler;        // Output-format conversion (optional)
+        RateVolumeProcessor* effects;  // Rate/volume DSP (optional)
+        CVibeVoiceTTSEngine* engine; // For event dispatch (optional)
+        size_t textBase;             // Sentence offset in the concatenated text
     };
 
+    // StreamTTS word-event callback: rebases the offset and fires SAPI events
+    static void WordEventProxy(DWORD textOffset, DWORD textLen, void* context);
+
+    // Pick up rate/volume changes flagged in a GetActions() result
+    static void UpdateEffects(ISpTTSEngineSite* pOutputSite, DWORD actions,
+                              RateVolumeProcessor* effects);
+
+    // Write cached PCM to the site in slices, honoring SPVES_ABORT and
+    // rate/volume changes. The cache holds native 24kHz PCM; rate, volume
+    // and conversion to the negotiated output format happen here, so cached
+    // entries serve any target rate. When text is provided, estimated word
+    // events for the buffer are queued as well.
+    HRESULT WritePcmToSite(ISpTTSEngineSite* pOutputSite, const BYTE* pcm,
+                           size_t size, Resampler* resampler,
+                           RateVolumeProcessor* effects,
+                           const std::wstring* text = nullptr,
+                           size_t textBase = 0);
+
     // Static callback for audio chunks
     static void AudioCallback(const BYTE* data, DWORD size, void* context);
+
+    // Polled by PipeClient while I/O is pending, so SPVES_ABORT is noticed
+    // even when no audio chunk is arriving
+    static bool CancelCheck(void* context);
 };
 
 
@@ -479,6 +479,11 @@ class VibeVoiceStreamingForConditionalGenerationInference(VibeVoiceStreamingPreT
         )
 
         acoustic_cache = VibeVoiceTokenizerStreamingCache()
+        # Private diffusion scheduler for this call: the model-level instance
+        # only serves as the config template. Servers interleave concurrent
+        # `generate()` calls (priority preemption, flow-control parking), and
+        # two threads stepping one scheduler corrupt both streams.
+        noise_scheduler = DPMSolverMultistepScheduler.from_config(self.model.noise_scheduler.config)
         batch_size = input_ids.shape[0]
         assert batch_size == 1, "Currently only supports batch size == 1"
         device = input_ids.device
@@ -597,6 +602,7 @@ class VibeVoiceStreamingForConditionalGenerationInference(VibeVoiceStreamingPreT
                     positive_condition,
                     negative_condition,
                     cfg_scale=cfg_scale,
+                    noise_scheduler=noise_scheduler,
                 ).unsqueeze(1)
                                 
                 # Decode acoustic latent to audio using acoustic streaming cache
@@ -704,18 +710,22 @@ class VibeVoiceStreamingForConditionalGenerationInference(VibeVoiceStreamingPreT
         )
 
     @torch.no_grad()
-    def sample_speech_tokens(self, condition, neg_condition, cfg_scale=3.0):
-        self.model.noise_scheduler.set_timesteps(self.ddpm_inference_steps)
+    def sample_speech_tokens(self, condition, neg_condition, cfg_scale=3.0, noise_scheduler=None):
+        # `set_timesteps`/`step` mutate solver state (step index, multistep
+        # model-output history), so concurrent `generate()` calls must not
+        # share a scheduler; callers that may overlap pass their own instance.
+        scheduler = noise_scheduler if noise_scheduler is not None else self.model.noise_scheduler
+        scheduler.set_timesteps(self.ddpm_inference_steps)
         condition = torch.cat([condition, neg_condition], dim=0).to(self.model.prediction_head.device)
         speech = torch.randn(condition.shape[0], self.config.acoustic_vae_dim).to(condition)
-        for t in self.model.noise_scheduler.timesteps:
+        for t in scheduler.timesteps:
             half = speech[: len(speech) // 2]
             combined = torch.cat([half, half], dim=0)
             eps = self.model.prediction_head(combined, t.repeat(combined.shape[0]).to(combined), condition=condition)
             cond_eps, uncond_eps = torch.split(eps, len(eps) // 2, dim=0)
             half_eps = uncond_eps + cfg_scale * (cond_eps - uncond_eps)
             eps = torch.cat([half_eps, half_eps], dim=0)
-            speech = self.model.noise_scheduler.step(eps, t, speech).prev_sample
+            speech = scheduler.step(eps, t, speech).prev_sample
         return speech[: len(speech) // 2]
     
 
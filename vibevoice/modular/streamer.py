@@ -3,7 +3,7 @@ from __future__ import annotations
 import torch
 
 import asyncio
-from queue import Queue
+from queue import Queue, Empty, Full
 from typing import TYPE_CHECKING, Optional
 
 
@@ -22,20 +22,28 @@ class AudioStreamer(BaseStreamer):
             The signal to put in the queue when generation ends. Defaults to None.
         timeout (`float`, *optional*):
             The timeout for the audio queue. If `None`, the queue will block indefinitely.
+        maxsize (`int`, *optional*):
+            Maximum chunks buffered per sample. `0` (the default) keeps the
+            historical unbounded behavior. A positive value makes `put()`
+            block the generation thread once the consumer falls that many
+            chunks behind, so a paused consumer genuinely pauses generation
+            instead of letting it run ahead unbounded.
     """
-    
+
     def __init__(
-        self, 
+        self,
         batch_size: int,
         stop_signal: Optional[any] = None,
         timeout: Optional[float] = None,
+        maxsize: int = 0,
     ):
         self.batch_size = batch_size
         self.stop_signal = stop_signal
         self.timeout = timeout
-        
+        self.maxsize = maxsize
+
         # Create a queue for each sample in the batch
-        self.audio_queues = [Queue() for _ in range(batch_size)]
+        self.audio_queues = [Queue(maxsize) for _ in range(batch_size)]
         self.finished_flags = [False for _ in range(batch_size)]
         self.sample_indices_map = {}  # Maps from sample index to queue index
         
@@ -52,7 +60,19 @@ class AudioStreamer(BaseStreamer):
             if idx < self.batch_size and not self.finished_flags[idx]:
                 # Convert to numpy or keep as tensor based on preference
                 audio_chunk = audio_chunks[i].detach().cpu()
-                self.audio_queues[idx].put(audio_chunk, timeout=self.timeout)
+                if not self.maxsize:
+                    self.audio_queues[idx].put(audio_chunk, timeout=self.timeout)
+                    continue
+                # Bounded queue: this is the backpressure point - block until
+                # the consumer drains a slot, re-checking the finished flag so
+                # an abandoned stream can't wedge the generation thread in a
+                # put() nobody will ever drain.
+                while not self.finished_flags[idx]:
+                    try:
+                        self.audio_queues[idx].put(audio_chunk, timeout=0.05)
+                        break
+                    except Full:
+                        continue
     
     def end(self, sample_indices: Optional[torch.Tensor] = None):
         """
@@ -62,18 +82,26 @@ class AudioStreamer(BaseStreamer):
             sample_indices: Optional tensor of sample indices to end. If None, ends all.
         """
         if sample_indices is None:
-            # End all samples
-            for idx in range(self.batch_size):
-                if not self.finished_flags[idx]:
-                    self.audio_queues[idx].put(self.stop_signal, timeout=self.timeout)
-                    self.finished_flags[idx] = True
+            indices_to_end = range(self.batch_size)
         else:
-            # End specific samples
-            for sample_idx in sample_indices:
-                idx = sample_idx.item() if torch.is_tensor(sample_idx) else sample_idx
-                if idx < self.batch_size and not self.finished_flags[idx]:
+            indices_to_end = [s.item() if torch.is_tensor(s) else s for s in sample_indices]
+
+        for idx in indices_to_end:
+            if idx < self.batch_size and not self.finished_flags[idx]:
+                # Flag first: it releases any producer blocked in a bounded
+                # put(), and lets consumers treat finished-and-empty as end
+                # of stream even if the sentinel below couldn't be queued
+                self.finished_flags[idx] = True
+                if not self.maxsize:
                     self.audio_queues[idx].put(self.stop_signal, timeout=self.timeout)
-                    self.finished_flags[idx] = True
+                    continue
+                try:
+                    self.audio_queues[idx].put_nowait(self.stop_signal)
+                except Full:
+                    # A full bounded queue can't take the sentinel without
+                    # blocking or dropping audio; consumers fall back to the
+                    # finished flag once they drain the remaining chunks
+                    pass
     
     def __iter__(self):
         """Returns an iterator over the batch of audio streams."""
@@ -97,10 +125,23 @@ class AudioSampleIterator:
         return self
     
     def __next__(self):
-        value = self.streamer.audio_queues[self.sample_idx].get(timeout=self.streamer.timeout)
-        if value == self.streamer.stop_signal:
-            raise StopIteration()
-        return value
+        if not self.streamer.maxsize:
+            value = self.streamer.audio_queues[self.sample_idx].get(timeout=self.streamer.timeout)
+            if value == self.streamer.stop_signal:
+                raise StopIteration()
+            return value
+        # Bounded mode: the end-of-stream sentinel is best-effort (a full
+        # queue can't take it), so poll and treat finished-and-empty as end
+        while True:
+            try:
+                value = self.streamer.audio_queues[self.sample_idx].get(timeout=0.05)
+            except Empty:
+                if self.streamer.finished_flags[self.sample_idx]:
+                    raise StopIteration()
+                continue
+            if value == self.streamer.stop_signal:
+                raise StopIteration()
+            return value
 
 
 class AudioBatchIterator:
@@ -135,10 +176,18 @@ class AudioBatchIterator:
         # Remove finished samples
         self.active_samples -= samples_to_remove
         
+        # In bounded mode the sentinel is best-effort; a sample whose queue
+        # drained after its finished flag was set is done even without one
+        if self.streamer.maxsize:
+            self.active_samples -= {
+                idx for idx in self.active_samples
+                if self.streamer.finished_flags[idx] and self.streamer.audio_queues[idx].empty()
+            }
+
         if batch_chunks:
             return batch_chunks
         elif self.active_samples:
-            # If no chunks were ready but we still have active samples, 
+            # If no chunks were ready but we still have active samples,
             # wait a bit and try again
             import time
             time.sleep(0.01)